@@ -0,0 +1,70 @@
+"""
+比较两次基准测试的结果 (make bench 输出的 JSONL)。
+
+用法: python bench/compare.py OLD.jsonl NEW.jsonl
+
+逐个局面列出节点数与耗时 (中位数) 的变化，最后按分类与总计汇总。
+结论与预期不符的局面标记为 FAIL；两份结果的局面集不一致时只比较 id 与分类都相同的局面。
+"""
+
+import json
+import sys
+
+
+def load(path):
+    positions, summary = {}, None
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            row = json.loads(line)
+            if row.get("summary"):
+                summary = row
+            else:
+                positions[row["id"]] = row
+    return positions, summary
+
+
+def ratio(new, old):
+    return "%+.1f%%" % ((new / old - 1) * 100) if old else "-"
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__.strip())
+        return 1
+    old, old_summary = load(sys.argv[1])
+    new, new_summary = load(sys.argv[2])
+
+    print("%4s  %-15s %12s %12s %8s %10s %10s %8s" %
+          ("id", "category", "nodes", "nodes'", "", "ms", "ms'", ""))
+    failed = 0
+    totals = {}
+    for pid in sorted(set(old) & set(new)):
+        a, b = old[pid], new[pid]
+        if a["category"] != b["category"]:
+            continue
+        mark = "" if b["ok"] else "  FAIL"
+        failed += not b["ok"]
+        print("%4d  %-15s %12d %12d %8s %10.2f %10.2f %8s%s" %
+              (pid, b["category"], a["nodes"], b["nodes"], ratio(b["nodes"], a["nodes"]),
+               a["time_ms"], b["time_ms"], ratio(b["time_ms"], a["time_ms"]), mark))
+        for key in (b["category"], "total"):
+            t = totals.setdefault(key, [0, 0, 0.0, 0.0])
+            t[0] += a["nodes"]
+            t[1] += b["nodes"]
+            t[2] += a["time_ms"]
+            t[3] += b["time_ms"]
+
+    print()
+    total = totals.pop("total", None)
+    for key, (n0, n1, t0, t1) in list(totals.items()) + ([("total", total)] if total else []):
+        print("%-21s nodes %s, time %s (%.1f ms -> %.1f ms)" % (key, ratio(n1, n0), ratio(t1, t0), t0, t1))
+    if old_summary and new_summary:
+        print("peak_rss_kb           %s -> %s" % (old_summary.get("peak_rss_kb"), new_summary.get("peak_rss_kb")))
+    return 2 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -11,45 +11,62 @@ if hasattr(sys, '_MEIPASS'):
     os.environ['TCL_LIBRARY'] = os.path.join(sys._MEIPASS, 'tcl8.6')
     os.environ['TK_LIBRARY'] = os.path.join(sys._MEIPASS, 'tk8.6')
 
-# C++ Solver Path
-SOLVER_PATH = "dou_solver.exe"
-
-class SolverThread:
-    def __init__(self, hand_a, hand_b, callback, error_callback):
-        self.hand_a = hand_a
-        self.hand_b = hand_b
+# C++ Solver Path: make 的输出 (bin/dou 或 bin\dou.exe)，相对于本脚本 (打包后为可执行文件) 所在目录
+BASE_DIR = os.path.dirname(sys.executable if getattr(sys, 'frozen', False) else os.path.abspath(__file__))
+SOLVER_PATH = os.path.join(BASE_DIR, "bin", "dou.exe" if os.name == 'nt' else "dou")
+# 每一步分析的时间上限 (毫秒)，超时后未证明的着法显示为 [未知]
+TIME_BUDGET_MS = 10000
+
+class SolverServer:
+    """常驻求解进程 (--server)：进程与置换表在各局之间保留，每局对应一个会话。
+
+    新开一局只需发送 new 命令，之前算过的局面直接命中缓存，不再每局重启进程。
+    """
+    def __init__(self, callback, error_callback):
         self.callback = callback
         self.error_callback = error_callback
         self.process = None
-        self.running = True
-        self.thread = threading.Thread(target=self.run)
-        self.thread.daemon = True
+        self.session = None
+        self.games = 0
+        self.lock = threading.Lock()
 
-    def start(self):
-        self.thread.start()
+    def ensure_started(self):
+        if self.process and self.process.poll() is None:
+            return
+        if not os.path.exists(SOLVER_PATH):
+            raise FileNotFoundError(f"找不到求解器 {SOLVER_PATH}，请先在仓库根目录运行 make")
+        creationflags = 0
+        if os.name == 'nt':
+            creationflags = subprocess.CREATE_NO_WINDOW
+
+        self.process = subprocess.Popen(
+            [SOLVER_PATH, "--server", "--score", "--time-ms", str(TIME_BUDGET_MS)],
+            stdin=subprocess.PIPE,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            text=True,
+            bufsize=1,
+            creationflags=creationflags
+        )
+        thread = threading.Thread(target=self.read_output, args=(self.process,))
+        thread.daemon = True
+        thread.start()
 
-    def run(self):
+    def new_game(self, hand_a, hand_b):
         try:
-            input_str = self.format_input(self.hand_a, self.hand_b)
+            # 保存手牌，下次启动时作为默认局面
             with open("input.txt", "w") as f:
-                f.write(input_str)
-
-            creationflags = 0
-            if os.name == 'nt':
-                creationflags = subprocess.CREATE_NO_WINDOW
-
-            self.process = subprocess.Popen(
-                [SOLVER_PATH, "--json"],
-                stdin=subprocess.PIPE,
-                stdout=subprocess.PIPE,
-                stderr=subprocess.PIPE,
-                text=True,
-                bufsize=0,
-                creationflags=creationflags
-            )
-
-            self.read_output()
-
+                f.write(self.format_input(hand_a, hand_b))
+            with self.lock:
+                self.ensure_started()
+                # 上一局的分析立即中断，其会话释放
+                if self.session:
+                    self.send("stop")
+                    self.send(f"close {self.session}")
+                self.games += 1
+                self.session = f"g{self.games}"
+                a, b = (" ".join(map(str, h + [0])) for h in (hand_a, hand_b))
+                self.send(f"new {self.session} {a} {b}")
         except Exception as e:
             self.error_callback(str(e))
 
@@ -58,40 +75,55 @@ class SolverThread:
             return " ".join(map(str, hand)) + " 0"
         return f"{line(hand_a)}\n{line(hand_b)}\n"
 
-    def send_input(self, index):
+    def send(self, command):
         if self.process and self.process.poll() is None:
-            try:
-                self.process.stdin.write(f"{index}\n")
-                self.process.stdin.flush()
-                # Reading happens in the run loop
-            except Exception as e:
-                self.error_callback(str(e))
-
-    def read_output(self):
-        if not self.process:
-            return
-            
-        while self.running:
-            line = self.process.stdout.readline()
-            if not line:
-                break
+            self.process.stdin.write(command + "\n")
+            self.process.stdin.flush()
+
+    def send_input(self, index):
+        try:
+            if self.session:
+                self.send(f"play {self.session} {index}")
+        except Exception as e:
+            self.error_callback(str(e))
+
+    def cancel(self):
+        # 中断正在进行的分析，求解器立即给出当前结果
+        try:
+            self.send("stop")
+        except Exception as e:
+            self.error_callback(str(e))
+
+    def read_output(self, process):
+        for line in process.stdout:
             line = line.strip()
             if not line:
                 continue
-            
+
             if line.startswith("{"):
                 try:
                     data = json.loads(line)
-                    self.callback(data)
                 except json.JSONDecodeError:
                     print(f"JSON Error: {line}")
+                    continue
+                # 忽略已结束的局 (以及 close 的确认)
+                if data.get("session") != self.session or data.get("closed"):
+                    continue
+                if "error" in data:
+                    self.error_callback(data["error"])
+                else:
+                    self.callback(data)
             else:
                 print(f"Solver Log: {line}")
 
     def stop(self):
-        self.running = False
-        if self.process:
-            self.process.terminate()
+        if self.process and self.process.poll() is None:
+            try:
+                self.send("stop")
+                self.send("quit")
+                self.process.wait(timeout=2)
+            except Exception:
+                self.process.terminate()
 
 class CardSelectorDialog(tk.Toplevel):
     def __init__(self, parent, initial_hand_a, initial_hand_b):
@@ -257,6 +289,10 @@ class NeoDouApp:
         self.root.geometry("900x700")
         
         self.solver = None
+        self.options = []   # 当前局面的选项 (分析过程中按 "event" 逐个更新)
+        self.best = None
+        self.pending = False
+        self.turn_status = ""
         self.hand_a = []
         self.hand_b = []
         
@@ -301,6 +337,9 @@ class NeoDouApp:
         
         self.btn_start = ttk.Button(controls, text="开始计算 (Start Solver)", command=self.start_solver)
         self.btn_start.pack(side=tk.LEFT, padx=5)
+
+        self.btn_stop = ttk.Button(controls, text="停止计算 (Stop)", command=self.stop_analysis)
+        self.btn_stop.pack(side=tk.LEFT, padx=5)
         
         # 5. Options
         ttk.Label(main_frame, text="推荐出牌 (Options):", font=("Arial", 12)).pack(anchor=tk.W)
@@ -405,20 +444,39 @@ class NeoDouApp:
             lbl.pack(side=tk.LEFT, padx=2)
 
     def start_solver(self):
-        if self.solver:
-            self.solver.stop()
-        
-        self.solver = SolverThread(self.hand_a, self.hand_b, self.on_solver_update, self.on_solver_error)
-        self.solver.start()
+        if not self.solver:
+            self.solver = SolverServer(self.on_solver_update, self.on_solver_error)
+        self.solver.new_game(list(self.hand_a), list(self.hand_b))
         
         self.btn_start.config(state=tk.DISABLED)
         self.status_var.set("正在计算...")
 
+    def stop_analysis(self):
+        if self.solver:
+            self.solver.cancel()
+
     def on_solver_update(self, data):
         # Use root.after to update UI from main thread
         self.root.after(0, lambda: self._update_ui(data))
 
     def _update_ui(self, data):
+        if data.get("event") == "progress":
+            # 分析进度 (每 0.5 秒一行)：已证明的分支数、节点数与速度
+            if self.pending:
+                self.status_var.set(f"{self.turn_status} - 正在计算... 已证明 {data['proven']}/{data['options']}，"
+                                    f"{data['nodes']} 节点，{data['knps']:.0f} knps，{data['time_ms'] / 1000:.1f} 秒")
+            return
+        if data.get("event") == "option":
+            # 分析过程中逐个给出的结论：只更新对应的选项
+            for opt in self.options:
+                if opt['id'] == data['id']:
+                    opt['win'] = data['win']
+                    # 分值分析 (--score)：到终局的手数与炸弹数
+                    opt['plies'] = data.get('plies')
+                    opt['bombs'] = data.get('bombs')
+            self.update_options(self.options, self.best)
+            return
+
         if "hand_a" in data:
             self.hand_a = data["hand_a"]
         if "hand_b" in data:
@@ -439,14 +497,33 @@ class NeoDouApp:
         else:
             self.status_var.set("轮到对手出牌 (Opponent Turn) - 请等待或手动选择")
             
-        self.update_options(data.get("options", []))
-
-    def update_options(self, options):
+        self.turn_status = self.status_var.get()
+        self.pending = data.get("pending", False)
+        if self.pending:
+            self.status_var.set(self.status_var.get() + " - 正在计算...")
+        elif not data.get("complete", True):
+            self.status_var.set(self.status_var.get() + " - 未完全求解")
+
+        self.options = data.get("options", [])
+        self.best = data.get("best")
+        self.update_options(self.options, self.best)
+
+    def update_options(self, options, best=None):
         self.clear_options()
         for opt in options:
-            prefix = "[必胜]" if not opt['win'] else "[必败]"
+            if opt['win'] is None and self.pending:
+                prefix, bg = "[计算中]", "#f8f8e0"
+            elif opt['win'] is None:
+                prefix, bg = "[未知]", "#e8e8e8"
+            elif not opt['win']:
+                prefix, bg = "[必胜]", "#d0f0c0"
+            else:
+                prefix, bg = "[必败]", "#f0d0d0"
+            if opt['win'] is None and not self.pending and opt['id'] == best:
+                prefix += "[推荐]"
             text = f"{prefix} {opt['desc']}"
-            bg = "#d0f0c0" if not opt['win'] else "#f0d0d0"
+            if opt.get('plies') is not None:
+                text += f"  ({opt['plies']} 手, {opt['bombs']} 炸)"
             
             btn = tk.Button(self.options_frame, text=text, bg=bg, font=("Arial", 11),
                             command=lambda idx=opt['id']: self.make_move(idx),
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdio>
+#include <cstddef>
+
+class TransTable;
+
+/**
+ * @brief 批量求解模式
+ *
+ * 从输入流中连续读取局面（格式与 input.txt 相同：每个局面两手牌，各以 0 结束），
+ * 由线程池并行求解，每个局面输出一行 JSON (JSONL)：
+ *
+ *   {"id": 0, "hand_a": [...], "hand_b": [...], "win": true,
+ *    "winning_moves": ["DAN 3", ...], "nodes": 1234, "time_ms": 0.52}
+ *
+ * 输出顺序为完成顺序，以 id (输入中的序号，从 0 开始) 区分。
+ * 每个工作线程持有一张固定大小的置换表并在局面之间复用，内存上限恒定；
+ * 若给出 shared (例如持久化置换表)，则所有工作线程共用这一张表。
+ * pn 引擎下每个工作线程还持有一个 PnSearcher，其 pn / dn 表同样在局面之间复用，
+ * 与置换表平分该线程的内存份额。输入在局面中途结束时，最后一行为 {"id": N, "error": ...}。
+ *
+ * players 为 3 时每个局面三手牌 (地主、地主下家、地主上家)，地主先出，
+ * 输出中增加 "hand_c"，"win" 与 "winning_moves" 为地主一方的结论；
+ * 每个工作线程使用自己的 ThreeSearcher (shared 不适用)。
+ *
+ * @param in 输入流
+ * @param workers 工作线程数
+ * @param hashMb 所有工作线程置换表的总内存上限 (MB)
+ * @param shared 共用的置换表 (nullptr 表示每个线程各自分配)
+ * @param players 玩家数 (2 或 3)
+ * @return 进程退出码
+ */
+int runBatch(FILE *in, int workers, size_t hashMb, TransTable *shared = nullptr, int players = 2);
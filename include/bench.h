@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdio>
+#include <cstddef>
+
+/**
+ * @brief 基准测试模式 (--bench)
+ *
+ * 读取基准局面集 (bench/corpus.txt)：每行一个局面
+ *
+ *   分类 预期结论(win/loss) A 的牌 0 B 的牌 0
+ *
+ * A 先自由出牌，# 开头的行与空行忽略。每个局面求解 repeat 次，每次使用新分配的
+ * 置换表 (互不影响，结果可复现)，单线程，按 --engine 选择搜索引擎。
+ * 每个局面输出一行 JSON：
+ *
+ *   {"id": 0, "category": "easy", "expected": true, "win": true, "ok": true,
+ *    "nodes": 1234, "time_ms": 0.52, "min_ms": 0.50, "knps": 2373.1,
+ *    "tt_probes": 2000, "tt_hit_rate": 0.213, "tt_kb": 1536}
+ *
+ * time_ms 为各次耗时的中位数，min_ms 为最小值；nodes 与查表次数每次都相同，取一次的值。
+ * tt_kb 为求解后置换表已占用的内存 (按占用率估算)，反映该局面自身的内存需求。
+ * 开启 --stats 时增加 "stats"
+ * (最后一次求解的 SearchStats::json()；分阶段计时本身会使 time_ms 变长)。
+ * 最后输出一行汇总 {"summary": true, ...}，含全部局面及各分类的合计，以及进程的峰值
+ * 常驻内存 peak_rss_kb (进程生命周期内单调不减，因此只在汇总中给出；不支持的平台为 null)。
+ *
+ * @param in 基准局面集
+ * @param repeat 每个局面的求解次数
+ * @param hashMb 置换表大小 (MB)
+ * @return 0 表示全部结论与预期一致，2 表示有不一致，1 表示输入错误
+ */
+int runBench(FILE *in, int repeat, size_t hashMb);
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include "stats.h"
+
+/**
+ * @brief 有预算的求解结果 (三态)
+ */
+enum class Outcome {
+    LOSS,    ///< 已证明必败
+    WIN,     ///< 已证明必胜
+    UNKNOWN, ///< 预算耗尽或被取消，尚未证明
+};
+
+/**
+ * @brief 搜索预算
+ *
+ * 各项为 0 表示不限。内存由启动时分配的固定大小表 (置换表、pn/dn 表) 约束，
+ * 搜索过程中不再增长，因此不单独设预算。
+ */
+struct SearchBudget {
+    unsigned long long timeMs = 0; ///< 墙钟时间上限 (毫秒)
+    unsigned long long nodes = 0;  ///< 节点数上限 (所有线程合计)
+
+    /// 是否设置了任何上限
+    bool limited() const { return timeMs || nodes; }
+};
+
+/**
+ * @brief 搜索控制 (预算与协作式取消)
+ *
+ * 一次分析 (可能包含多次求解、多个线程) 共用一个 SearchControl。
+ * 搜索器每展开 POLL_NODES 个节点调用一次 charge() 记账并检查预算；
+ * 任何线程都可以随时调用 cancel()，搜索器在下一个节点处返回。
+ * 开启 --stats 时，使用它的搜索器把统计同时并入这里，得到只属于本次分析的合计
+ * (服务模式下各会话的分析并发进行，全局合计会混在一起)。
+ */
+class SearchControl {
+public:
+    /// 搜索器记账的间隔 (节点数)
+    static const unsigned long long POLL_NODES = 1024;
+
+    SearchControl() : halted(false), used(0) {}
+
+    /**
+     * @brief 按预算开始一次新的分析 (清除取消状态、统计，重新计时)
+     *
+     * 只能在没有搜索运行时调用。
+     */
+    void start(const SearchBudget &b);
+
+    /// 取消当前分析 (线程安全，可从任意线程调用)
+    void cancel() { halted.store(true, std::memory_order_relaxed); }
+
+    /// 是否已取消或预算耗尽
+    bool stopped() const { return halted.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 记入 n 个节点并检查预算
+     * @return true 表示应当停止
+     */
+    bool charge(unsigned long long n);
+
+    /// 已记账的节点数
+    unsigned long long nodes() const { return used.load(std::memory_order_relaxed); }
+
+    /// 自 start() 以来经过的毫秒数
+    double elapsedMs() const;
+
+    /// 把一份统计并入本次分析的合计 (线程安全)
+    void addStats(const SearchStats &s);
+
+    /// 本次分析的统计合计的快照 (线程安全)
+    SearchStats stats() const;
+
+private:
+    SearchBudget budget;
+    std::chrono::steady_clock::time_point begin;
+    std::atomic<bool> halted;
+    std::atomic<unsigned long long> used;
+    mutable std::mutex statsMu;
+    SearchStats total; ///< 本次分析的统计合计
+};
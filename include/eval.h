@@ -0,0 +1,61 @@
+#pragma once
+
+#include "hand.h"
+#include "move.h"
+#include <vector>
+
+/**
+ * @brief 一手出完
+ *
+ * 判断手牌 a 本身是否构成一个能压过 p 的合法牌型 (单张、对子、三带、炸弹、王炸、
+ * 顺子、连对、飞机、四带二)。直接在压缩手牌上判断，不生成着法。
+ *
+ * @param a 当前玩家手牌 (非空)
+ * @param p 上家出的牌
+ * @return 能一手出完返回 true
+ */
+bool oneMoveFinish(Hand a, Move p);
+
+/**
+ * @brief 静态胜负判定 (控制分析)
+ *
+ * 在生成着法之前识别确定必胜的局面，结果是严格证明的 (不使用任何估计)：
+ *   - 一手出完：手牌本身是能压过上家的牌型；
+ *   - 控制：轮到 a 自由出牌，a 的手牌按点数自然分组 (单、对、三、炸，双王为王炸)，
+ *     其中敌方能压过的组至多一个 (三张可以各带走一个能被压过的单张或对子)。
+ *     a 依次打出压不住的组，敌方只能 PASS，最后打出剩下的一组即出完。
+ *     敌方只剩一张牌时，这就是"除最后一手外没有比它小的单张"。
+ *
+ * @param a 当前玩家手牌
+ * @param b 对手手牌
+ * @param p 上家出的牌
+ * @return true 表示 a 必胜；false 表示无法静态判定 (不代表必败)
+ */
+bool staticWin(Hand a, Hand b, Move p);
+
+/**
+ * @brief 带牌的等价与支配判定
+ *
+ * 三带、四带二、飞机的主牌相同而带牌不同的着法，对手的应对完全相同，只有 a 剩下的手牌不同。
+ * 设着法从点数 y 带走 k 张，把这 k 张换成点数 x < y (不在带牌与主牌中) 得到着法 m'，
+ * 出牌前 (带走 y 之前) x 与 y 的张数相同，x、y 都不可能参与连牌且都不是王。此时两种出法剩下的手牌只是交换了 x、y 两个点数：
+ *   - m 带走 y 的全部张数：m' 留下的是同样张数、点数更高的牌，每一手都不弱于 m (支配)；
+ *   - 对手在 [x, y] 之间没有牌：交换不改变任何与对手的大小关系 (等价)。
+ * 两种情况下 m 的结果都不会好于 m'，搜索只需保留 m'。
+ *
+ * @param a 出牌前的手牌
+ * @param b 对手手牌
+ * @param m 着法
+ * @return true 表示存在不劣于 m 的另一种带牌，m 可以不搜索
+ */
+bool dominatedKick(Hand a, Hand b, Move m);
+
+/**
+ * @brief 从着法列表中删除带牌被支配的着法
+ *
+ * 删除 [base, moves.size()) 中 dominatedKick() 为真的着法 (保持其余着法的顺序)，
+ * 胜负结论不变。仅用于搜索，交互界面仍列出全部着法。
+ *
+ * @return 剩余着法数
+ */
+size_t pruneKicks(Hand a, Hand b, std::vector<Move> &moves, size_t base);
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "pai.h"
+
+/**
+ * @brief 取最低位 1 的下标 (count trailing zeros)
+ */
+static inline int lowBit(unsigned long long x) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long idx;
+    _BitScanForward64(&idx, x);
+    return (int)idx;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+/**
+ * @brief 取最高位 1 的下标
+ */
+static inline int highBit(unsigned long long x) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long idx;
+    _BitScanReverse64(&idx, x);
+    return (int)idx;
+#else
+    return 63 - __builtin_clzll(x);
+#endif
+}
+
+/**
+ * @brief 统计 1 的个数
+ */
+static inline int popCount(unsigned long long x) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return (int)__popcnt64(x);
+#else
+    return __builtin_popcountll(x);
+#endif
+}
+
+/**
+ * @brief 压缩手牌 (Packed Hand)
+ *
+ * 15 种牌（3-大王）的数量压缩在一个 64 位整数中，每种牌 3 bits，
+ * 点数 r 位于 bits [(r-3)*3, (r-3)*3+3)。
+ * 出牌/回溯是一次 64 位减法/加法，判空是一次零测试。
+ *
+ * "数量 >= k" 的掩码采用展开形式 (spread mask)：点数 r 满足条件时，
+ * 对应字段的最低位 (bit (r-3)*3) 为 1。顺子等牌型可以直接用同样布局的掩码做包含测试。
+ */
+struct Hand {
+    unsigned long long bits;
+
+    /// 每个字段最低位为 1 的常量
+    static const unsigned long long LSB = 0x49249249249ULL;
+
+    /// 点数 r 对应字段的位移
+    static int shift(int r) { return (r - 3) * 3; }
+
+    /// 从手牌数组构造
+    static Hand fromArray(const int *arr) {
+        Hand h;
+        h.bits = 0;
+        for (int i = 3; i < MAX_N; i++) {
+            h.bits |= ((unsigned long long)arr[i] & 0x7) << shift(i);
+        }
+        return h;
+    }
+
+    /// 展开为手牌数组 (索引 3-17)
+    void toArray(int *arr) const {
+        for (int i = 3; i < MAX_N; i++) arr[i] = count(i);
+    }
+
+    /// 点数 r 的张数
+    int count(int r) const { return (int)((bits >> shift(r)) & 7); }
+
+    /// 是否已打完
+    bool empty() const { return bits == 0; }
+
+    /// 总张数 (按字段的 bit0/bit1/bit2 分别计数加权)
+    int size() const {
+        return popCount(bits & LSB) + 2 * popCount(bits & (LSB << 1)) + 4 * popCount(bits & (LSB << 2));
+    }
+
+    /// 数量 >= 1 的点数掩码
+    unsigned long long ge1() const { return (bits | (bits >> 1) | (bits >> 2)) & LSB; }
+    /// 数量 >= 2 的点数掩码 (2,3 的 bit1 为 1；4 的 bit2 为 1)
+    unsigned long long ge2() const { return ((bits >> 1) | (bits >> 2)) & LSB; }
+    /// 数量 >= 3 的点数掩码 (3 = 011，4 = 100)
+    unsigned long long ge3() const { return ((bits & (bits >> 1)) | (bits >> 2)) & LSB; }
+    /// 数量 >= 4 的点数掩码
+    unsigned long long ge4() const { return (bits >> 2) & LSB; }
+
+    /// 数量 >= k 的点数掩码
+    unsigned long long ge(int k) const {
+        switch (k) {
+            case 1: return ge1();
+            case 2: return ge2();
+            case 3: return ge3();
+            case 4: return ge4();
+            default: return 0;
+        }
+    }
+
+    bool operator==(Hand o) const { return bits == o.bits; }
+    bool operator!=(Hand o) const { return bits != o.bits; }
+};
+
+/// 展开掩码中的字段下标转为点数
+static inline int fieldRank(int bit) { return bit / 3 + 3; }
+
+/**
+ * @brief 从文本流读取一手牌 (与 input.txt 相同：点数以空白分隔，以 0 结束)
+ * @param arr 手牌数组 (累加到其中，调用前应清零)
+ * @param error 格式错误时的说明
+ * @return 格式错误 (非法点数、张数超过上限、不是整数的记号、缺少结尾的 0) 时返回 false
+ */
+static inline bool parseHand(istream &in, int *arr, string &error) {
+    int x;
+    while (in >> x) {
+        if (x == 0) return true;
+        if (x < 3 || x >= MAX_N) {
+            error = "invalid card " + to_string(x);
+            return false;
+        }
+        if (++arr[x] > (x >= 16 ? 1 : 4)) {
+            error = "too many cards of " + to_string(x);
+            return false;
+        }
+    }
+    // 输入结束前读取失败说明遇到了不是整数的记号
+    error = in.eof() ? "hand must end with 0" : "invalid token";
+    return false;
+}
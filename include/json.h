@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include "hand.h"
+
+/**
+ * @brief 转义 JSON 字符串
+ */
+inline std::string json_escape(const std::string& s) {
+    std::string ret = "";
+    for (char c : s) {
+        if (c == '"') ret += "\\\"";
+        else if (c == '\\') ret += "\\\\";
+        else ret += c;
+    }
+    return ret;
+}
+
+/**
+ * @brief 手牌转为 JSON 数组 (每张牌一个点数，升序)
+ */
+inline std::string json_hand(Hand h) {
+    std::string ret = "[";
+    bool first = true;
+    for (int i = 3; i < MAX_N; i++) {
+        for (int k = 0; k < h.count(i); k++) {
+            if (!first) ret += ",";
+            ret += std::to_string(i);
+            first = false;
+        }
+    }
+    return ret + "]";
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <vector>
+#include "pai.h"
+#include "hand.h"
+
+/// 每种牌型的主牌在每个点数上占用的张数
+extern const int kPaiUnit[10];
+
+/**
+ * @brief 点数 h..h+l-1 每个字段最低位置 1 的值 (Hand 布局，编译期常量)
+ *
+ * l 个字段的最低位之和为 (2^(3l) - 1) / 7，再平移到点数 h；超出大王的部分截掉。
+ */
+constexpr unsigned long long runBits(int h, int l) {
+    return h < 3 ? 0 : ((((1ULL << (3 * l)) - 1) / 7) << (3 * (h - 3))) & Hand::LSB;
+}
+
+/**
+ * @brief 连续点数掩码表
+ *
+ * bits[h][l] = runBits(h, l)，涵盖所有顺子、连对、飞机机身。在编译期生成 (常量初始化)。
+ */
+struct RunTable {
+    unsigned long long bits[MAX_N][13];
+};
+extern const RunTable kRunTable;
+
+/// 能组成连牌的点数 3..A 的字段
+static const unsigned long long RUN_RANKS = Hand::LSB & ((1ULL << Hand::shift(15)) - 1);
+
+/**
+ * @brief 连续段的起点掩码
+ *
+ * g 为"数量 >= k"的展开掩码，返回所有满足 h..h+len-1 都在 g 中 (且不超过 A) 的起点 h。
+ * 所有起点在同一个 64 位字中并行测试 (移位后按位与)，不再逐个窗口扫描。
+ */
+static inline unsigned long long runStarts(unsigned long long g, int len) {
+    g &= RUN_RANKS;
+    unsigned long long s = g;
+    for (int i = 1; i < len; i++) s &= g >> (3 * i);
+    return s;
+}
+
+/**
+ * @brief 紧凑着法 (Compact Move)
+ *
+ * 搜索中使用的值类型着法，一个 64 位整数即可描述任意牌型，不需要堆分配和虚函数。
+ * 位布局：
+ *   - bits  0-44 : 带牌（翅膀）计数，每种点数 3 bits，布局与 Hand 相同
+ *   - bits 48-51 : 牌型 (PaiType)
+ *   - bits 52-56 : 主牌起点 head（单张/对子/三张/炸弹即为其点数）
+ *   - bits 57-60 : 主牌点数个数 length（单点牌型为 1，王炸为 2）
+ *   - bits 61-62 : 带牌类别 wing（0=不带, 1=带单, 2=带对）
+ *
+ * 主牌部分由 (type, head, length) 查表得到：每个点数扣除 unit(type) 张。
+ * 带牌字段与 Hand 布局相同，因此 delta() 可以直接作用于压缩手牌。
+ */
+struct Move {
+    unsigned long long bits;
+
+    static const unsigned long long KICK_MASK = (1ULL << 45) - 1;
+
+    /**
+     * @brief 构造着法
+     * @param t 牌型
+     * @param head 主牌起点
+     * @param length 主牌点数个数
+     * @param wing 带牌类别
+     * @param kick 带牌计数（3 bits 一个点数）
+     */
+    static Move make(PaiType t, int head, int length, int wing, unsigned long long kick) {
+        Move m;
+        m.bits = kick
+               | ((unsigned long long)t << 48)
+               | ((unsigned long long)head << 52)
+               | ((unsigned long long)length << 57)
+               | ((unsigned long long)wing << 61);
+        return m;
+    }
+
+    /// 不出
+    static Move pass() { return make(PaiType::PASS_T, 0, 0, 0, 0); }
+
+    /// 点数 r 在带牌字段中对应的单位增量
+    static unsigned long long kickBit(int r) { return 1ULL << ((r - 3) * 3); }
+
+    PaiType type() const { return (PaiType)((bits >> 48) & 0xF); }
+    int head() const { return (int)((bits >> 52) & 0x1F); }
+    int length() const { return (int)((bits >> 57) & 0xF); }
+    int wing() const { return (int)((bits >> 61) & 0x3); }
+    unsigned long long kick() const { return bits & KICK_MASK; }
+    bool isPass() const { return type() == PaiType::PASS_T; }
+
+    /// 形状：比较大小时必须一致的部分 (type, length, wing)
+    unsigned int shape() const {
+        return (unsigned int)(((bits >> 48) & 0xF) | (((bits >> 57) & 0x3F) << 4));
+    }
+
+    /// 带牌中最小 / 最大的点数 (无带牌时返回 0)
+    int kickLow() const { return kick() ? lowBit(kick()) / 3 + 3 : 0; }
+    int kickHigh() const { return kick() ? highBit(kick()) / 3 + 3 : 0; }
+
+    /**
+     * @brief 编码为 32 位整数 (用于记忆化表的 Key)
+     *
+     * 与 Pai::encode() 含义一致：三带与四带二记录带牌点数，飞机不记录翅膀。
+     */
+    unsigned int encode() const {
+        unsigned int code = (unsigned int)type() | (head() << 4) | (length() << 9) | (wing() << 13);
+        if (type() == PaiType::SANDAI_T || type() == PaiType::SIDAIER_T) {
+            code |= (kickLow() << 15) | (kickHigh() << 20);
+        }
+        return code;
+    }
+
+    bool operator==(Move o) const { return bits == o.bits; }
+    bool operator!=(Move o) const { return bits != o.bits; }
+
+    /**
+     * @brief 比较牌型大小
+     * @param pre 上家出的牌
+     * @return 如果当前牌能压过 pre，返回 true
+     */
+    bool operator>(Move pre) const {
+        PaiType t = type(), pt = pre.type();
+        if (pt == PaiType::PASS_T) return t != PaiType::PASS_T;
+        if (t == PaiType::PASS_T) return true;
+        if (t == PaiType::WANGZHA_T) return pt != PaiType::WANGZHA_T;
+        if (pt == PaiType::WANGZHA_T) return false;
+        if (t == PaiType::ZHADAN_T) return pt != PaiType::ZHADAN_T || head() > pre.head();
+        if (pt == PaiType::ZHADAN_T) return false;
+        return shape() == pre.shape() && head() > pre.head();
+    }
+
+    /// 主牌部分 (Hand 布局)
+    unsigned long long body() const {
+        return (unsigned long long)kPaiUnit[(int)type()] * kRunTable.bits[head()][length()];
+    }
+
+    /// 整手牌的扣除量 (Hand 布局)
+    unsigned long long delta() const { return body() + kick(); }
+
+    /// 从压缩手牌中扣除 (一次 64 位减法)
+    void take(Hand &h) const { h.bits -= delta(); }
+    /// 加回压缩手牌 (一次 64 位加法)
+    void back(Hand &h) const { h.bits += delta(); }
+
+    /// 从手牌数组中扣除
+    void take(int *arr) const;
+    /// 加回手牌数组
+    void back(int *arr) const;
+};
+
+/**
+ * @brief 分阶段的惰性着法生成器 (Pull-based)
+ *
+ * 每次 next() 追加一种牌型的全部合法着法，调用者可以在找到必胜着法后停止拉取，
+ * 其余牌型不再生成。阶段顺序为 PASS、王炸、炸弹、三带、飞机、四带二、连对、顺子、
+ * 对子、单张 (与原 getLegalPai() 排序后的顺序一致)，同一阶段内按点数降序。
+ *
+ * 生成受上家出牌约束：上家不是 PASS 时只进入 PASS、王炸、炸弹和上家牌型这几个阶段，
+ * 并且只枚举起点更大、长度与带法相同的组合，不会生成再被过滤掉的着法。
+ */
+class MoveGen {
+public:
+    /**
+     * @param h 当前手牌
+     * @param pre 上家出的牌
+     */
+    MoveGen(Hand h, Move pre);
+
+    /**
+     * @brief 生成下一个阶段的着法
+     *
+     * 着法被追加到 out 的末尾 (不清空已有内容)，没有着法的阶段会被跳过。
+     *
+     * @return 所有阶段都已生成完毕时返回 false (此时没有追加任何着法)
+     */
+    bool next(vector<Move> &out);
+
+private:
+    enum Stage {
+        PASS_S, ROCKET_S, BOMB_S, SANDAI_S, FEIJI_S, SIDAIER_S,
+        LIANDUI_S, SHUNZI_S, DUIZI_S, DAN_S, DONE_S,
+    };
+
+    void genStage(Stage s, vector<Move> &out) const;
+
+    Hand hand;
+    Move pre;
+    Stage stage;         ///< 下一个阶段
+    unsigned int stages; ///< 需要生成的阶段 (按位)
+    int minHead;         ///< 跟同牌型时主牌起点的下界
+};
+
+/**
+ * @brief 生成能够压制上家牌的所有合法着法 (无堆分配版本的 Pai::getLegalPai)
+ *
+ * 着法被追加到 out 的末尾，调用者负责在使用后截断，便于在递归中复用同一块缓冲区。
+ * 等价于把 MoveGen 的所有阶段依次拉取完。
+ *
+ * @param h 当前手牌
+ * @param pre 上家出的牌
+ * @param out 输出缓冲区
+ */
+void genLegalMoves(Hand h, Move pre, vector<Move> &out);
+
+/**
+ * @brief 将紧凑着法转换为 Pai 对象 (仅用于显示)
+ * @return 新分配的 Pai 对象，调用者负责 delete
+ */
+Pai *toPai(Move m);
+
+/**
+ * @brief 获取牌型对象的文字描述 (Pai::output() 的输出)
+ */
+string describePai(Pai *p);
+
+/**
+ * @brief 获取着法的文字描述 (与 Pai::output() 相同)
+ */
+string describeMove(Move m);
+
+/// 牌型名 ("DAN"、"DUIZI" ... "PASS"，与 PaiType 的枚举名相同)
+const char *typeName(PaiType t);
@@ -177,9 +177,12 @@ public:
  */
 class SANDAI : public Pai {
     int x;     ///< 三张的主值
-    Pai *dai;  ///< 带的牌 (PASS, DAN, DUIZI)
+    Pai *dai;  ///< 带的牌 (PASS, DAN, DUIZI)，由 SANDAI 持有
 public:
     SANDAI(int x, Pai *dai);
+    ~SANDAI() override { delete dai; }
+    SANDAI(const SANDAI &) = delete;
+    SANDAI &operator=(const SANDAI &) = delete;
     static vector<Pai *> get(int *arr);
     ostream& output() override;
     bool operator>(Pai *pre) override;
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdio>
+
+/**
+ * @brief perft 使用的着法生成器
+ */
+enum class PerftGen {
+    FAST, ///< MoveGen / genLegalMoves (Hand、Move 值类型，搜索使用)
+    REF,  ///< Pai::getLegalPai (Pai 类层次，参考实现)
+    BOTH, ///< 两者都运行并比较结果
+};
+
+/**
+ * @brief 着法生成器的 perft 校验与吞吐量测试 (--perft)
+ *
+ * 从输入流读取局面 (格式与 input.txt 相同：每个局面两手牌，各以 0 结束；# 开头的行为注释)，
+ * A 先自由出牌。
+ * 对 depth = 1..maxDepth 统计恰好 depth 手的合法出牌序列数 (PASS 也算一手；有人出完时
+ * 序列提前结束，计入 ends 而不计入 nodes)，每个局面每个深度输出一行 JSON：
+ *
+ *   {"id": 0, "depth": 3, "nodes": 23810, "ends": 0, "generated": 24587,
+ *    "moves": {"DAN": 9001, ...}, "fast": {"ms": 1.9, "moves_per_sec": 12940526},
+ *    "ref": {"ms": 61.3, "moves_per_sec": 401093}, "match": true}
+ *
+ * moves 为最后一手的牌型分布，generated 为所有节点生成的着法总数 (吞吐量以它计算)。
+ * BOTH 时两个生成器各自计时；结果不一致时逐个节点比较两者的着法集合 (按文字描述)，
+ * 输出前几个不一致的局面：
+ *
+ *   {"id": 0, "depth": 3, "mismatch": {"path": ["DAN 3", "PASS"], "hand": [...], "other": [...],
+ *    "last": "DAN 3", "missing": [...], "extra": [...]}}
+ *
+ * hand 为当前出牌方的手牌，missing 为参考实现有而 MoveGen 没有的着法，extra 相反。
+ *
+ * @param in 输入流
+ * @param maxDepth 最大深度
+ * @param gen 使用的生成器
+ * @return 0 表示 (BOTH 时) 两者一致，2 表示不一致，1 表示输入错误
+ */
+int runPerft(FILE *in, int maxDepth, PerftGen gen);
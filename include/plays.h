@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include "hand.h"
+#include "move.h"
+
+/**
+ * @brief 最少出牌次数 (Minimum Plays)
+ *
+ * 不考虑对手时，把手牌 h 全部打完最少需要几手。
+ * 动态规划：任何拆法中都必须有一手包含最小点数的牌，因此只需枚举覆盖最小点数的
+ * 着法 m，取 1 + minPlays(h - m) 的最小值。结果缓存在全局的无锁直接映射表中
+ * (同时记录达到最小值的第一手)，搜索中每个节点都可以查询。
+ *
+ * @param h 手牌
+ * @return 最少手数 (空手牌为 0)
+ */
+int minPlays(Hand h);
+
+/**
+ * @brief 最少出牌次数的一种拆法
+ * @param h 手牌
+ * @param plan 输出：依次打出即可出完的着法 (共 minPlays(h) 手)
+ */
+void minPlan(Hand h, std::vector<Move> &plan);
+
+/**
+ * @brief 对手能否压过某一手牌 (可能高估，不会低估)
+ *
+ * 王炸、炸弹、同牌型更大的主牌都会被计入；三带、飞机的带牌是否凑得齐不做检查。
+ *
+ * @param b 对手手牌
+ * @param g 打出的牌
+ */
+bool canBeat(Hand b, Move g);
+
+/**
+ * @brief 上家出牌对当前玩家的约束编码 (置换表 Key 的出牌部分)
+ *
+ * 当前玩家只关心哪些着法能压过 p：牌型、长度、翅膀数，以及自己能作为起点的点数中
+ * 有几个不大于 p 的起点。带牌、起点的具体点数都不影响应对，因此
+ * "三带 7 带 3" 与 "三带 7 带 9" 编码相同；a 根本压不过的出牌 (只能 PASS)
+ * 不论牌型都编码为同一个值 (与王炸相同)。PASS 编码为 0。
+ *
+ * @param a 当前玩家手牌
+ * @param p 上家出的牌
+ */
+unsigned int responseCode(Hand a, Move p);
+
+/**
+ * @brief 出牌竞速的必胜判定
+ *
+ * 轮到 a 自由出牌时，若 a 的最少手数拆法中对手能压过的至多一手，a 先打出
+ * 其余各手 (对手只能 PASS)，最后打出这一手即出完。
+ *
+ * @return true 表示 a 必胜；false 表示无法判定
+ */
+bool raceWin(Hand a, Hand b);
+
+/**
+ * @brief 出牌竞速的必败判定
+ *
+ * 对手只剩王炸，或只剩一个炸弹而 a 没有更大的炸弹 (和王炸)：a 不能一手出完时，
+ * 无论 a 出什么或 PASS，对手都能一手出完。
+ *
+ * @return true 表示 a 必败；false 表示无法判定
+ */
+bool raceLoss(Hand a, Hand b, Move p);
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include "hand.h"
+#include "move.h"
+#include "tt.h"
+#include "tablebase.h"
+#include "budget.h"
+
+/**
+ * @brief 证明数搜索器 (df-pn, Depth-First Proof-Number Search)
+ *
+ * 与 Searcher 求解同一个问题 (当前玩家是否必胜)，但不按固定顺序深度优先，
+ * 而是用证明数 / 反证数 (pn / dn) 引导搜索，总是展开"最便宜的证明"所在的分支，
+ * 适合着法很多 (三带、飞机的带牌组合) 而胜负只取决于少数分支的局面。
+ *
+ * 以当前玩家的视角 (negamax) 记录：
+ *   - pn：证明当前玩家必胜至少还需要展开的叶子数；
+ *   - dn：证明当前玩家必败至少还需要展开的叶子数；
+ *   - pn(n) = min(dn(子))，dn(n) = sum(pn(子))。
+ *
+ * 着法生成、终局判定 (provenResult) 与 Searcher 相同。已证明的局面写入共享的
+ * 置换表 (与 Searcher 通用)，未证明的中间 pn / dn 保存在搜索器自己的表中。
+ */
+class PnSearcher {
+public:
+    /**
+     * @param stop 外部停止标志 (可为 nullptr)
+     * @param table 保存已证明结果的置换表 (nullptr 表示全局共享表)
+     * @param mb pn / dn 表的内存上限 (MB)
+     */
+    explicit PnSearcher(const std::atomic<bool> *stop = nullptr, TransTable *table = nullptr, size_t mb = 64);
+    ~PnSearcher();
+    PnSearcher(const PnSearcher &) = delete;
+    PnSearcher &operator=(const PnSearcher &) = delete;
+
+    /**
+     * @brief 求解局面
+     * @return true 如果当前玩家(a)必胜；若 aborted() 为真则结果无意义
+     */
+    bool solve(Hand a, Hand b, Move p);
+
+    /**
+     * @brief 指定预算 (节点数、时间) 与取消控制
+     * @param c 控制对象 (nullptr 表示不限)
+     */
+    void setControl(SearchControl *c) { control = c; }
+
+    /**
+     * @brief 把尚未记账的节点计入预算 (一次求解结束后调用)
+     *
+     * 同时把搜索统计并入全局合计 (flushStats)。
+     */
+    void flushNodes();
+
+    /// 搜索是否因停止标志或预算耗尽而中断
+    bool aborted() const { return stopped; }
+
+    /// 已展开的节点数
+    unsigned long long nodes() const { return nodeCount; }
+
+    /// 共享置换表 (已证明结果) 的查询次数
+    unsigned long long tableProbes() const { return probeCount; }
+
+    /// 共享置换表的查询命中次数
+    unsigned long long tableHits() const { return hitCount; }
+
+private:
+    /// pn / dn 表项 (完整的规范局面作 Key，结果精确)
+    struct Entry {
+        unsigned long long a;     ///< 我方手牌，bit 63 为有效位
+        unsigned long long b;     ///< 敌方手牌
+        unsigned int code;        ///< 上家出牌编码
+        unsigned int pn;
+        unsigned int dn;
+        unsigned int work;        ///< 子树展开次数 (替换策略)
+    };
+
+    bool lookup(const PositionKey &key, unsigned int &pn, unsigned int &dn) const;
+    void save(const PositionKey &key, unsigned int pn, unsigned int dn, unsigned int work);
+
+    /**
+     * @brief 取子局面的 pn / dn (未展开过的子局面先做终局判定，否则取初始值)
+     */
+    void childValue(Hand a, Hand b, Move p, unsigned int &pn, unsigned int &dn);
+
+    /**
+     * @brief 多重迭代加深 (Multiple Iterative Deepening)
+     *
+     * 展开节点直到 pn >= thpn 或 dn >= thdn，返回时 pn / dn 为该节点的最新值。
+     */
+    void mid(Hand a, Hand b, Move p, unsigned int thpn, unsigned int thdn, unsigned int &pn, unsigned int &dn);
+
+    /// 检查停止标志与预算 (每 SearchControl::POLL_NODES 个节点记账一次)
+    bool interrupted();
+
+    TransTable *table;
+    const Tablebase *tb;
+    const std::atomic<bool> *stop;
+    SearchControl *control;
+    unsigned long long charged; ///< 已计入预算的节点数
+    bool stopped;
+    unsigned long long nodeCount;
+    unsigned long long probeCount; ///< 共享置换表查询次数
+    unsigned long long hitCount;   ///< 共享置换表命中次数
+    unsigned long long statsMark[3]; ///< 已并入搜索统计的节点数、查表次数、命中次数
+
+    /// 开启搜索统计时把节点数与查表次数并入全局合计 (pn 引擎只统计这几项)
+    void flushStats();
+
+    Entry *entries;
+    size_t entryMask;
+
+    std::vector<Move> moveStack;
+    std::vector<unsigned int> pnStack; ///< 与着法栈对齐：子局面的 pn
+    std::vector<unsigned int> dnStack; ///< 与着法栈对齐：子局面的 dn
+};
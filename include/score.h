@@ -0,0 +1,142 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "search.h"
+
+/// 每一手在分值中的权重 (一条线上的炸弹数总是小于它)
+static const int SCORE_PLY = 32;
+/// 胜负分值的基数
+static const int SCORE_WIN = 4096;
+/// 大于任何分值的绝对值
+static const int SCORE_INF = 1 << 14;
+
+/**
+ * @brief 局面的分值：双方都按最优策略出牌时的终局手数与炸弹数
+ *
+ * 分值 value() 对当前玩家而言，必胜为正、必败为负，绝对值为
+ * SCORE_WIN - 手数 * SCORE_PLY + 炸弹数。因此胜方先求最快出完，手数相同时打出更多炸弹
+ * (倍数更高)；负方先求拖延，手数相同时让炸弹更少。双方都以此为目标，是零和的。
+ */
+struct Score {
+    bool win;  ///< 当前玩家是否必胜
+    int plies; ///< 到有人出完为止的手数 (PASS 也算一手)
+    int bombs; ///< 其间双方打出的炸弹与王炸数
+
+    /// 对应的分值
+    int value() const {
+        int v = SCORE_WIN - plies * SCORE_PLY + bombs;
+        return win ? v : -v;
+    }
+
+    /// 由分值还原
+    static Score fromValue(int v) {
+        Score s;
+        s.win = v > 0;
+        int m = SCORE_WIN - (v > 0 ? v : -v);
+        s.plies = (m + SCORE_PLY - 1) / SCORE_PLY;
+        s.bombs = s.plies * SCORE_PLY - m;
+        return s;
+    }
+};
+
+/**
+ * @brief 分值搜索器 (最快取胜、最慢落败、炸弹数)
+ *
+ * 失败软化 (fail-soft) 的 alpha-beta 搜索，结果存入带边界类型的 ScoreTable。
+ * 双方的最少出牌手数给出分值的上下界，区间落在窗口之外时直接返回 (手数距离剪枝)；
+ * 窗口跨过 0 时先用布尔搜索器 (Searcher，共享胜负置换表) 判定胜负，把窗口收到一侧。
+ * score() 先判定胜负，再以 MTD(f) 的零窗口测试逼近精确分值：每次测试只需证明
+ * "不晚于 / 不早于某一手出完"，搜索范围受手数限制，总耗时与布尔求解同一量级。
+ * 单线程；多个搜索器可以共享同一张表。
+ */
+class ScoreSearcher {
+public:
+    /**
+     * @param table 使用的分值表 (nullptr 表示全局分值表)
+     */
+    explicit ScoreSearcher(ScoreTable *table = nullptr);
+
+    /**
+     * @brief 指定预算 (节点数、时间) 与取消控制
+     * @param c 控制对象 (nullptr 表示不限)
+     */
+    void setControl(SearchControl *c) {
+        control = c;
+        signs.setControl(c);
+    }
+
+    /**
+     * @brief 求局面的精确分值
+     * @param a 当前玩家手牌
+     * @param b 对手手牌 (非空)
+     * @param p 上家打出的牌
+     * @param s 写入分值
+     * @return 被中断 (预算耗尽或取消) 时返回 false
+     */
+    bool score(Hand a, Hand b, Move p, Score &s);
+
+    /**
+     * @brief 零窗口 / 窗口搜索
+     * @return 分值 v：alpha < v < beta 时为精确值，v <= alpha 时为上界，v >= beta 时为下界；
+     *         若 aborted() 为真则结果无意义
+     */
+    int search(Hand a, Hand b, Move p, int alpha, int beta);
+
+    /// 把尚未记账的节点计入预算
+    void flushNodes();
+
+    /// 搜索是否因预算耗尽而中断
+    bool aborted() const { return stopped; }
+
+    /// 分值搜索展开的节点数 (不含胜负判定的节点)
+    unsigned long long nodes() const { return nodeCount; }
+
+private:
+    /// 检查预算 (每 SearchControl::POLL_NODES 个节点记账一次)
+    bool interrupted();
+
+    Searcher signs; ///< 胜负判定
+    ScoreTable *table;
+    SearchControl *control;
+    bool stopped;
+    unsigned long long nodeCount;
+    unsigned long long charged; ///< 已计入预算的节点数
+
+    std::vector<Move> moveStack; ///< 各层共享的着法栈 (同 Searcher)
+    std::vector<int> keyStack;   ///< 排序时与着法栈对齐的排序键
+};
+
+/**
+ * @brief 全局分值表
+ */
+ScoreTable &scoreTable();
+
+/**
+ * @brief 开启或关闭分值分析 (--score)
+ */
+void enableScore(bool on);
+
+/// 是否开启分值分析
+bool scoreEnabled();
+
+/// 着法是否为炸弹或王炸 (计入倍数)
+inline bool isBomb(Move m) {
+    return m.type() == PaiType::ZHADAN_T || m.type() == PaiType::WANGZHA_T;
+}
+
+/**
+ * @brief 在预算内求根节点各个着法的分值
+ *
+ * 对 moves 中的每个着法 m 求打出 m 之后的分值，换算为当前玩家 a 的视角：
+ * plies 与 bombs 包含 m 本身。setThreads() 个线程各自领取下一个着法，共享分值表与胜负表。
+ *
+ * @param a 当前玩家手牌
+ * @param b 对手手牌
+ * @param moves a 的着法 (须合法)
+ * @param control 预算与取消控制 (nullptr 表示不限)
+ * @param report 每得到一个结果立即调用 report(i, s)，在工作线程中串行调用；
+ *               被中断的着法不调用
+ */
+void scoreMoves(Hand a, Hand b, const std::vector<Move> &moves, SearchControl *control,
+                const std::function<void(size_t, const Score &)> &report);
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "hand.h"
+#include "move.h"
+#include "tt.h"
+#include "tablebase.h"
+#include "eval.h"
+#include "plays.h"
+#include "budget.h"
+#include "stats.h"
+
+/**
+ * @brief 不需要搜索即可确定的结论
+ *
+ * 依次尝试：残局库 (自由出牌局面)、静态判定 (一手出完、控制)、出牌竞速 (最少手数)。
+ * 各搜索引擎在展开节点之前调用。
+ *
+ * @param tb 残局库 (可为 nullptr)
+ * @param win 命中时写入 a 是否必胜
+ * @return 是否得到结论
+ */
+bool provenResult(Hand a, Hand b, Move p, const Tablebase *tb, bool &win);
+
+/**
+ * @brief 单线程搜索器
+ *
+ * 保存一个线程的全部搜索状态（着法栈、节点计数、当前层数）。
+ * 多个搜索器可以同时运行并共享同一张无锁置换表 (Lazy SMP)。
+ */
+class Searcher {
+public:
+    /**
+     * @param id 线程编号 (0 为主线程；其余线程在浅层使用不同的着法顺序)
+     * @param stop 外部停止标志，置位后搜索尽快返回 (可为 nullptr)
+     * @param table 使用的置换表 (nullptr 表示全局共享表)
+     */
+    explicit Searcher(int id = 0, const std::atomic<bool> *stop = nullptr, TransTable *table = nullptr);
+
+    /// 析构时把尚未并入的统计计入全局合计
+    ~Searcher() { flushStats(); }
+
+    /**
+     * @brief 快速求解函数 (Zero-Allocation Solver)
+     *
+     * 纯递归函数，不创建 Node 对象，着法使用 Move 值类型，手牌使用 Hand 压缩形式
+     * (按值传递，出牌/回溯都是寄存器内的一次加减法)，用于快速判定胜负。
+     *
+     * @param a 当前玩家手牌
+     * @param b 对手玩家手牌
+     * @param p 上家打出的牌
+     * @return true 如果当前玩家(a)必胜；若 aborted() 为真则结果无意义
+     */
+    bool solve(Hand a, Hand b, Move p);
+
+    /**
+     * @brief 指定查询的残局库
+     *
+     * 默认使用全局残局库 (已加载时)；生成残局库时指向正在生成的表。
+     * @param t 残局库 (nullptr 表示不查询)
+     */
+    void useTablebase(const Tablebase *t) { tb = t; }
+
+    /**
+     * @brief 指定预算 (节点数、时间) 与取消控制
+     * @param c 控制对象 (nullptr 表示不限)
+     */
+    void setControl(SearchControl *c) { control = c; }
+
+    /// 把尚未记账的节点计入预算 (一次求解结束后调用)
+    void flushNodes();
+
+    /// 搜索是否因停止标志或预算耗尽而中断
+    bool aborted() const { return stopped; }
+
+    /// 已搜索的节点数
+    unsigned long long nodes() const { return nodeCount; }
+
+    /// 置换表查询次数 (展开节点前的查表，不含 ETC 对子局面的查询)
+    unsigned long long tableProbes() const { return probeCount; }
+
+    /// 置换表查询命中次数
+    unsigned long long tableHits() const { return hitCount; }
+
+private:
+    /// 杀手着法表的层数上限
+    static const int MAX_PLY = 128;
+    /// 历史表大小 (以着法编码的低 15 位为下标：牌型、主牌点数、长度、带牌方式)
+    static const int HISTORY_SIZE = 1 << 15;
+
+    /**
+     * @brief 着法排序
+     *
+     * 对着法栈 [base, base + n) 排序：本层的杀手着法在前；其余着法中，打出后
+     * 最少手数减少的 (属于最优拆法) 在前，再按历史得分降序；得分相同时保持生成顺序。
+     */
+    void orderMoves(Hand a, size_t base, size_t n);
+
+    /// 记录在本层造成截断 (必胜) 的着法
+    void recordCutoff(Move m, int weight);
+
+    /// 检查停止标志与预算 (每 SearchControl::POLL_NODES 个节点记账一次)
+    bool interrupted();
+
+    /// 把本搜索器的统计并入全局合计 (未开启统计时什么也不做)
+    void flushStats();
+
+    int id;
+    int ply;
+    TransTable *table;
+    const Tablebase *tb;
+    bool stopped;
+    unsigned long long nodeCount;
+    unsigned long long probeCount; ///< 置换表查询次数
+    unsigned long long hitCount;   ///< 置换表命中次数
+    const std::atomic<bool> *stop;
+    SearchControl *control;
+    unsigned long long charged; ///< 已计入预算的节点数
+
+    std::unique_ptr<SearchStats> stats; ///< 尚未并入全局合计的统计 (未开启统计时为空)
+    unsigned long long statsMark[3];    ///< 已并入全局合计的节点数、查表次数、命中次数
+
+    /**
+     * @brief 着法栈
+     *
+     * 所有递归层共享的着法缓冲区：每层把生成的着法追加到末尾，返回前截断。
+     * 预热后不再发生任何堆分配。
+     */
+    std::vector<Move> moveStack;
+    std::vector<unsigned int> scoreStack; ///< 排序时与着法栈对齐的得分
+
+    Move killers[MAX_PLY][2];          ///< 每层最近两次造成截断的着法
+    std::vector<unsigned int> history; ///< 着法造成截断的累计权重
+};
+
+/**
+ * @brief 全局置换表 (所有线程共享)
+ */
+TransTable &sharedTable();
+
+/**
+ * @brief 设置搜索线程数
+ * @param n 线程数 (>= 1)
+ */
+void setThreads(int n);
+
+/// 当前搜索线程数
+int threadCount();
+
+/**
+ * @brief 搜索引擎
+ */
+enum class Engine {
+    DFS, ///< 深度优先 (Searcher，支持 Lazy SMP 多线程)
+    PN,  ///< 证明数搜索 (PnSearcher，单线程)
+};
+
+/// 选择搜索引擎
+void setEngine(Engine e);
+
+/// 当前搜索引擎
+Engine engine();
+
+/**
+ * @brief 求解一个局面 (按 setEngine() / setThreads() 的设置选择引擎，串行或并行)
+ *
+ * 并行模式为 Lazy SMP：所有线程从同一局面出发，在浅层以不同顺序展开着法，
+ * 通过共享置换表互相利用结果；第一个完成的线程给出答案，其余线程随即停止。
+ * 置换表只保存完整搜索得到的精确结果，因此答案与串行完全一致。
+ *
+ * @return true 如果当前玩家(a)必胜
+ */
+bool solveRoot(Hand a, Hand b, Move p);
+
+/**
+ * @brief 在预算内求解一个局面
+ *
+ * 与 solveRoot(a, b, p) 相同，但在 control 取消或预算耗尽时尽快返回 UNKNOWN。
+ * 同一个 control 可以跨多次调用累计节点数与时间。
+ *
+ * @param control 预算与取消控制 (nullptr 表示不限)
+ */
+Outcome solveRoot(Hand a, Hand b, Move p, SearchControl *control);
+
+/**
+ * @brief 在预算内求解根节点的全部着法 (multi-PV)
+ *
+ * 对 moves 中的每个着法 m 求解打出 m 之后的局面 (对手 b 先出，需压过 m)，
+ * 每个着法恰好求解一次。DFS 引擎由 setThreads() 个线程各自领取下一个尚未求解的着法，
+ * 互相通过共享置换表利用结果，总耗时取决于最难的单个着法而不是所有着法之和；
+ * 只有一个着法时退化为 solveRoot() (Lazy SMP)。PN 引擎依次求解。
+ *
+ * @param a 当前玩家手牌
+ * @param b 对手手牌
+ * @param moves a 的着法 (须合法)
+ * @param control 预算与取消控制 (nullptr 表示不限)
+ * @param report 每得到一个结果立即调用 report(i, r)，r 为打出 moves[i] 后对手 b 的结论；
+ *               按完成顺序、在工作线程中串行调用
+ */
+void solveMoves(Hand a, Hand b, const std::vector<Move> &moves, SearchControl *control,
+                const std::function<void(size_t, Outcome)> &report);
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include "budget.h"
+
+/**
+ * @brief 常驻求解服务 (--server)
+ *
+ * 进程常驻，置换表 (以及 --tt-file / --tb) 在各局之间保持，新开一局时之前算过的
+ * 局面直接命中。通过按行的文本协议接收命令，每条命令回复一行 JSON：
+ *
+ *   new SID <A 的牌> 0 <B 的牌> 0   开始 (或替换) 会话 SID，分析 A 先出的局面
+ *   play SID N                       当前出牌方选择第 N 个着法 (-1 为回退)
+ *   back SID                         回退一步
+ *   show SID                         重新输出最近一次的局面 (不重新分析，分析期间为 "pending" 局面)
+ *   close SID                        结束会话，释放其博弈树
+ *   stats                            会话数、会话内存与置换表占用率
+ *   stop                             立即中断本连接正在进行的分析
+ *   quit                             执行完已收到的命令后关闭本连接 (标准输入模式下退出进程)
+ *
+ * 输入在 quit 之前结束 (客户端断开) 时，尚未执行的命令被丢弃，正在进行的分析立即中断。
+ *
+ * 局面的回复与 --json 交互模式相同，另加 "session"；出错时回复 {"error": ...}。
+ * 需要分析时，回复之前先逐行输出分析过程 (analyzeNode() 的 "pending" 局面与 "event" 行)。
+ * 会话名在所有连接之间共享，可以同时打开任意多个会话。不同会话的分析并发进行
+ * (各自 --threads 个线程，共享置换表)；同一会话的命令依次执行，stats 与 show 不等待分析。
+ * 会话博弈树的总内存超过上限时，最久未使用的会话被淘汰，之后对它的命令回复 "unknown session"。
+ */
+struct ServerOptions {
+    const char *socketPath = nullptr; ///< Unix socket 路径 (nullptr 表示标准输入/输出)
+    SearchBudget budget;              ///< 每一步分析的预算
+    size_t sessionMb = 64;            ///< 所有会话博弈树的内存上限 (MB)
+};
+
+/**
+ * @brief 运行求解服务 (直到输入结束或 quit；socket 模式下不返回，除非出错)
+ *
+ * 调用前应已分配置换表 (initHash / initHashFile)。
+ *
+ * @return 进程退出码
+ */
+int runServer(const ServerOptions &opt);
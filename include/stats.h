@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+/// 统计计时用的单调时钟 (纳秒)
+static inline unsigned long long statsClock() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief 搜索统计 (--stats)
+ *
+ * 各搜索器在开启统计时持有一份自己的计数 (不加锁)，每 SearchControl::POLL_NODES 个节点
+ * 以及求解结束时并入全局合计 (addStats)。未开启时搜索器不分配计数，热路径上只多一次
+ * 空指针判断，不读时钟。
+ */
+struct SearchStats {
+    /// 分阶段计时的阶段
+    enum Phase {
+        PROVEN, ///< 不需要搜索的结论 (残局库、静态判定、出牌竞速)
+        PROBE,  ///< 展开节点前的查表
+        GEN,    ///< 着法生成与带牌约简
+        ETC,    ///< 增强置换截断 (查子局面)
+        ORDER,  ///< 着法排序
+        PHASES,
+    };
+    /// 深度直方图的桶数 (更深的层计入最后一个桶)
+    static const int DEPTHS = 64;
+    /// 牌型数 (PaiType 的取值个数)
+    static const int TYPES = 10;
+
+    unsigned long long nodes = 0;   ///< 展开的节点数
+    unsigned long long probes = 0;  ///< 置换表查询次数
+    unsigned long long hits = 0;    ///< 置换表命中次数
+    unsigned long long stores = 0;  ///< 置换表写入次数
+    unsigned long long proven = 0;  ///< 不需要搜索即得到结论的节点数
+    unsigned long long cutoffs = 0; ///< 递归后截断 (找到必胜着法) 的节点数
+    unsigned long long firstCutoffs = 0; ///< 其中第一个着法即截断的节点数 (衡量着法排序)
+    unsigned long long etcCutoffs = 0;   ///< 由子局面查表直接截断的节点数
+    unsigned long long moves[TYPES] = {};      ///< 按牌型统计生成的着法数
+    unsigned long long depth[DEPTHS] = {};     ///< 按层统计展开的节点数
+    unsigned long long phaseNs[PHASES] = {};   ///< 各阶段耗时 (纳秒)
+
+    /// 把自 t 起的耗时计入阶段 ph，返回当前时刻
+    unsigned long long lap(Phase ph, unsigned long long t) {
+        unsigned long long now = statsClock();
+        phaseNs[ph] += now - t;
+        return now;
+    }
+
+    /// 累加另一份统计
+    void add(const SearchStats &o);
+
+    /// 单行 JSON 对象 (progress 事件与基准测试输出)
+    std::string json() const;
+
+    /// 多行文本报告 (--stats)
+    void print(FILE *out) const;
+};
+
+/**
+ * @brief 开启或关闭搜索统计 (在创建搜索器之前设置)
+ */
+void enableStats(bool on);
+
+/// 是否开启了搜索统计
+bool statsEnabled();
+
+/// 把一份统计并入全局合计 (线程安全)
+void addStats(const SearchStats &s);
+
+/// 全局合计的快照 (线程安全)
+SearchStats totalStats();
+
+/// 清空全局合计 (开始新的一次分析时调用)
+void resetStats();
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include "hand.h"
+#include "move.h"
+
+/**
+ * @brief 残局库文件格式版本
+ *
+ * 手牌编号方式或规则 (着法生成) 发生变化时必须递增，旧文件拒绝加载。
+ */
+static const unsigned int TB_FILE_VERSION = 1;
+
+/**
+ * @brief 残局库支持的每方最大张数
+ *
+ * 表的大小约为手牌数的平方：N=4 约 1.6 MB，N=5 约 24 MB (生成约 2 分钟)，
+ * N=6 约 260 MB，N=7 超过 2 GB，因此只支持到 5。
+ */
+static const int TB_MAX_CARDS = 5;
+
+/**
+ * @brief 小残局库 (Endgame Tablebase)
+ *
+ * 保存双方手牌都不超过 N 张时所有"自由出牌"局面 (上家 PASS，轮到 a 任意出牌)
+ * 的精确胜负，每个局面 1 bit。
+ *
+ * 手牌编号：所有不超过 N 张的手牌按点数 3..大王 的张数做字典序排列，
+ * 编号由预先计算的组合数表一次扫描得到 (完美哈希，无冲突)。
+ * 局面 (a, b) 位于第 rank(a) 行、第 rank(b) 列；每行按 64 位对齐，
+ * 双方合计超过 4 张的点数等不可能局面对应的位留空。
+ *
+ * 只收录自由出牌局面：一轮出牌 (直到某方 PASS) 之后必然回到自由出牌局面，
+ * 因此搜索在每一轮结束时都可以命中，而表的大小只有全部局面的极小一部分。
+ */
+class Tablebase {
+public:
+    Tablebase();
+    ~Tablebase();
+    Tablebase(const Tablebase &) = delete;
+    Tablebase &operator=(const Tablebase &) = delete;
+
+    /**
+     * @brief 生成残局库
+     *
+     * 按双方合计张数从小到大逐层求解：求解某一层的局面时，一轮出牌结束后
+     * 到达的自由出牌局面张数更少，已经在表中，搜索在那里直接截断。
+     * 同一层的局面互不依赖，由 workers 个线程并行求解。
+     *
+     * @param cards 每方最大张数 N (1 - TB_MAX_CARDS)
+     * @param workers 线程数
+     * @param err 失败时的错误信息
+     * @return 成功返回 true
+     */
+    bool build(int cards, int workers, std::string &err);
+
+    /// 写入文件
+    bool save(const char *path, std::string &err) const;
+
+    /// 从文件加载
+    bool load(const char *path, std::string &err);
+
+    /// 是否已加载 (或生成)
+    bool ready() const { return words != nullptr; }
+
+    /// 每方最大张数
+    int cards() const { return maxCards; }
+
+    /// 表的大小 (字节)
+    size_t bytes() const { return handCount * rowWords * sizeof(unsigned long long); }
+
+    /**
+     * @brief 查询自由出牌局面 (a 先出) 的胜负
+     * @param win 命中时写入 a 是否必胜
+     * @return 双方都不超过 N 张时命中
+     */
+    bool probe(Hand a, Hand b, bool &win) const {
+        if (a.size() > maxCards || b.size() > maxCards) return false;
+        win = get(rank(a), rank(b));
+        return true;
+    }
+
+private:
+    /// 手牌编号 (0 - handCount-1)
+    size_t rank(Hand h) const {
+        size_t idx = 0;
+        int left = maxCards;
+        for (int r = 3; r < MAX_N; r++) {
+            int c = h.count(r);
+            idx += prefix[r - 3][left][c];
+            left -= c;
+        }
+        return idx;
+    }
+
+    bool get(size_t ia, size_t ib) const {
+        return (words[ia * rowWords + (ib >> 6)].load(std::memory_order_relaxed) >> (ib & 63)) & 1;
+    }
+
+    void set(size_t ia, size_t ib) {
+        words[ia * rowWords + (ib >> 6)].fetch_or(1ULL << (ib & 63), std::memory_order_relaxed);
+    }
+
+    bool allocate(int cards);
+    void release();
+
+    int maxCards;
+    size_t handCount;
+    size_t rowWords;
+    std::atomic<unsigned long long> *words;
+
+    /**
+     * @brief 编号表
+     *
+     * prefix[i][k][c]：点数 i+3 取 c 张、其余点数 (i+4 .. 大王) 合计不超过 k-c 张时，
+     * 排在它前面的手牌数 (即点数 i+3 取 0..c-1 张的补全方案总数)。
+     */
+    size_t prefix[15][TB_MAX_CARDS + 1][5];
+};
+
+/**
+ * @brief 全局残局库 (由 --tb 加载，搜索时自动查询)
+ */
+Tablebase &tablebase();
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "hand.h"
+#include "move.h"
+#include "budget.h"
+
+/// 三人局面的座位数
+static const int SEATS = 3;
+
+/**
+ * @brief 两个座位是否属于同一阵营 (座位 0 为地主，1、2 为农民)
+ */
+static inline bool sameTeam(int x, int y) { return x == y || (x != 0 && y != 0); }
+
+/**
+ * @brief 三人局面 (地主 vs 两个农民，明牌)
+ *
+ * 座位 0 为地主，1 为地主下家，2 为地主上家，按 0 -> 1 -> 2 -> 0 轮流出牌。
+ * 出牌后连续两人 PASS，最后出牌的人重新自由出牌。
+ * 任何一人出完即结束：地主出完地主胜，任一农民出完两个农民同胜。
+ */
+struct ThreeState {
+    Hand hand[SEATS]; ///< 各座位的手牌
+    int turn;         ///< 轮到出牌的座位
+    Move last;        ///< 需要压过的牌 (PASS 表示自由出牌)
+    int passes;       ///< last 之后已经连续 PASS 的人数 (0 或 1)
+
+    /// 出牌前的局面：地主先自由出牌
+    static ThreeState deal(Hand landlord, Hand down, Hand up) {
+        ThreeState s;
+        s.hand[0] = landlord;
+        s.hand[1] = down;
+        s.hand[2] = up;
+        s.turn = 0;
+        s.last = Move::pass();
+        s.passes = 0;
+        return s;
+    }
+
+    /// 当前座位打出 m 之后的局面 (m 必须合法)
+    ThreeState after(Move m) const {
+        ThreeState n = *this;
+        m.take(n.hand[turn]);
+        if (!m.isPass()) {
+            n.last = m;
+            n.passes = 0;
+        } else if (++n.passes == 2) {
+            // 另外两人都 PASS：轮回出牌者，自由出牌
+            n.last = Move::pass();
+            n.passes = 0;
+        }
+        n.turn = (turn + 1) % SEATS;
+        return n;
+    }
+
+    /// 已经出完的座位 (没有时为 -1)
+    int finished() const {
+        for (int i = 0; i < SEATS; i++) {
+            if (hand[i].empty()) return i;
+        }
+        return -1;
+    }
+};
+
+/**
+ * @brief 三人局面搜索器
+ *
+ * 与 Searcher 相同的深度优先 AND/OR 搜索，按阵营取胜负：轮到的座位只要有一个着法
+ * 使本阵营获胜即为必胜 (下一个出牌者是队友时沿用其结果，否则取反)。
+ * 局面按空点压缩规范化 (compressGaps)，上家出牌按对当前座位 (以及
+ * 当前座位 PASS 后下一座位) 的约束编码 (responseCode)，结果存入搜索器自己的
+ * 固定大小置换表 (每个桶 64 字节，两个 32 字节的表项，完整局面作 Key，结果精确)。
+ *
+ * 带牌约简 (pruneKicks) 不适用：农民之间可能需要留小牌让队友接手，
+ * "剩下的牌更大不会更差"在有队友时不成立。单线程。
+ */
+class ThreeSearcher {
+public:
+    /**
+     * @param mb 置换表的内存上限 (MB)
+     */
+    explicit ThreeSearcher(size_t mb = 64);
+    ~ThreeSearcher();
+    ThreeSearcher(const ThreeSearcher &) = delete;
+    ThreeSearcher &operator=(const ThreeSearcher &) = delete;
+
+    /**
+     * @brief 求解局面
+     * @return true 如果轮到出牌的座位所在阵营必胜；若 aborted() 为真则结果无意义
+     */
+    bool solve(const ThreeState &s);
+
+    /**
+     * @brief 指定预算 (节点数、时间) 与取消控制
+     * @param c 控制对象 (nullptr 表示不限)
+     */
+    void setControl(SearchControl *c) { control = c; }
+
+    /// 把尚未记账的节点计入预算 (一次求解结束后调用)
+    void flushNodes();
+
+    /// 搜索是否因预算耗尽或取消而中断
+    bool aborted() const { return stopped; }
+
+    /// 已搜索的节点数
+    unsigned long long nodes() const { return nodeCount; }
+
+    /// 置换表是否分配成功
+    bool ready() const { return entries != nullptr; }
+
+    /// 置换表实际占用内存 (字节)
+    size_t bytes() const { return entries ? (entryMask + 1) * sizeof(Entry) : 0; }
+
+private:
+    /// 置换表表项 (规范化后的三手牌与出牌约束作 Key)
+    struct Entry {
+        unsigned long long hand[SEATS];
+        unsigned long long meta; ///< bits 0-31 Key 的其余部分，bit 32 胜负，bit 33 有效位，bits 34-63 work
+    };
+
+    /// 规范化的局面 Key
+    struct Key {
+        unsigned long long hand[SEATS];
+        unsigned long long meta;
+        unsigned long long hash;
+    };
+
+    static Key makeKey(const ThreeState &s);
+    bool lookup(const Key &k, bool &win) const;
+    void save(const Key &k, bool win, unsigned long long work);
+
+    bool search(const ThreeState &s);
+
+    /// 历史表的大小 (按着法编码取模)
+    static const int HISTORY_SIZE = 1 << 15;
+
+    /**
+     * @brief 着法排序
+     *
+     * 对着法栈 [base, base + n) 排序：上家是队友时 PASS 在前；其余着法中，属于最优拆法的、
+     * 下家是对手且压不住的加分，再按该座位的历史得分降序。
+     */
+    void orderMoves(const ThreeState &s, size_t base, size_t n);
+
+    /// 记录座位 seat 造成截断 (必胜) 的着法
+    void recordCutoff(int seat, Move m, int weight);
+
+    /// 检查预算 (每 SearchControl::POLL_NODES 个节点记账一次)
+    bool interrupted();
+
+    SearchControl *control;
+    unsigned long long charged; ///< 已计入预算的节点数
+    bool stopped;
+    unsigned long long nodeCount;
+
+    Entry *entries;
+    size_t entryMask;
+
+    std::vector<Move> moveStack;          ///< 所有递归层共享的着法栈
+    std::vector<unsigned int> scoreStack; ///< 排序时与着法栈对齐的得分
+    std::vector<unsigned int> history[SEATS]; ///< 各座位着法造成截断的累计权重
+};
+
+/**
+ * @brief 分配三人局面的全局搜索器 (交互模式使用)
+ * @param mb 置换表的内存上限 (MB)
+ * @return 分配成功返回 true
+ */
+bool initThree(size_t mb);
+
+/**
+ * @brief 在预算内判断当前座位打出 m 之后本阵营是否必胜
+ *
+ * 使用 initThree() 分配的全局搜索器 (结果在各次调用之间复用)。
+ * m 打完手牌时直接判胜。
+ *
+ * @param s 当前局面
+ * @param m 当前座位的合法着法
+ * @param control 预算与取消控制 (nullptr 表示不限)
+ */
+Outcome solveThreeMove(const ThreeState &s, Move m, SearchControl *control);
@@ -1,41 +1,193 @@
 #pragma once
+#include <functional>
 #include <vector>
 #include <map>
 #include <string>
 #include <tuple>
 #include "pai.h"
+#include "move.h"
+#include "budget.h"
 
 
+/// 博弈树节点的编号 (GameTree 中的下标)
+typedef unsigned int NodeId;
+
 /**
  * @brief 博弈树节点
  * 
  * 记录了当前的胜负状态、上一步打出的牌以及后续分支。
+ * 节点存放在 GameTree 的节点池中，同一节点的子节点连续存放，以编号互相引用。
  */
-class Node {
+struct Node {
+    Move m;                  ///< 到达此节点所打出的牌 (上家出的牌)，显示时通过 toPai() 转换
+    NodeId child;            ///< 第一个子节点的编号 (childCount 为 0 时无意义)
+    unsigned int childCount; ///< 后续可能的走法分支数
+    bool win;                ///< 当前节点胜负状态 (true=必胜, false=必败)
+    bool known;              ///< 胜负是否已证明 (false 表示预算耗尽，win 无意义)
+    bool scored;             ///< 是否已求出分值 (--score，见 score.h)
+    unsigned char plies;     ///< 从打出 m 起到终局的手数 (scored 时有效)
+    unsigned char bombs;     ///< 其间双方打出的炸弹与王炸数，含 m 本身 (scored 时有效)
+};
+
+/**
+ * @brief 交互界面的博弈树 (节点池)
+ *
+ * 所有节点存放在一个数组中，子节点按块 (连续的 childCount 个节点) 分配；
+ * 释放的块按大小放入空闲链表，之后分配同样大小的块时直接复用，
+ * 因此来回浏览时占用的内存不会持续增长。增加节点可能使数组重新分配，
+ * 此前取得的 Node 引用随之失效，应始终通过编号访问。
+ */
+class GameTree {
 public:
-    Node();
+    /// 根节点的编号
+    static const NodeId ROOT = 0;
+
+    /// 只有根节点 (上家 PASS) 的树
+    GameTree();
+
+    Node &operator[](NodeId id) { return nodes[id]; }
+    const Node &operator[](NodeId id) const { return nodes[id]; }
+
+    /// 节点 id 的第 i 个子节点
+    NodeId child(NodeId id, int i) const { return nodes[id].child + i; }
+
+    /**
+     * @brief 为节点 id 的每个着法建立子节点 (胜负未知)
+     * @param id 还没有子节点的节点
+     */
+    void addChildren(NodeId id, const vector<Move> &moves);
+
+    /**
+     * @brief 释放节点 id 的所有后代 (id 本身及其胜负结论保留)
+     */
+    void releaseChildren(NodeId id);
+
     /**
-     * @brief 构造函数
-     * @param p 上一步打出的牌
-     * @param win 当前节点代表的玩家是否必胜
+     * @brief 进入节点 parent 的第 i 个分支
+     *
+     * 释放其余分支的后代：只保留当前路径上各节点的子节点，
+     * 沿同一路径回退、前进时结论直接复用，换一个分支时旧分支的子树被回收。
+     * @return 进入的子节点编号
      */
-    Node(Pai *p, bool win);
-    
-    bool win;           ///< 当前节点胜负状态 (true=必胜, false=必败)
-    Pai *p;             ///< 到达此节点所打出的牌 (上家出的牌)
-    vector<Node *> child; ///< 后续可能的走法分支
+    NodeId enter(NodeId parent, int i);
+
+    /// 占用的内存 (字节，估算)
+    size_t bytes() const;
+
+private:
+    vector<Node> nodes;
+    std::map<unsigned int, vector<NodeId>> freeBlocks; ///< 块大小 -> 空闲块的起始编号
 };
 
 /**
  * @brief 构建/搜索博弈树
  * 
- * 使用 Min-Max 算法和记忆化搜索来判定当前局面的胜负。
+ * 为当前玩家的每个合法着法建立子节点 (已有子节点时沿用)，并求解其中所有尚未证明的分支
+ * (multi-PV：每个着法求解一次，多线程时并行，见 solveMoves())。已证明的分支不再重算，
+ * 因此回退后再次到达同一节点时直接复用。子节点本身不再向下展开。
+ * 给出 control 时在其预算内求解：来不及证明的分支 known 为 false，
+ * 若据此无法确定根节点的胜负，根节点的 known 也为 false。
+ * 开启分值分析 (--score) 时，随后用 scoreMoves() 求出已证明而尚无分值的分支的手数与炸弹数，
+ * 每得到一个分值再调用一次 report。
  * 
- * @param root 当前根节点
+ * @param tree 博弈树
+ * @param root 当前节点
  * @param a 当前玩家手牌 (轮到谁出牌)
  * @param b 对手玩家手牌
+ * @param control 预算与取消控制 (nullptr 表示不限)
+ * @param report 每个分支得到结论或分值时立即调用 report(子节点下标) (在搜索线程中串行调用)
+ */
+void getTree(GameTree &tree, NodeId root, int *a, int *b, SearchControl *control = nullptr,
+             const std::function<void(int)> &report = nullptr);
+
+/**
+ * @brief 当前最好的着法
+ *
+ * 已证明必胜的分支优先；否则在尚未证明的分支中选打出后最少手数最小的；
+ * 全部必败时返回第一个分支。有分值时，必胜分支中取分值最高的 (最快取胜)，
+ * 全部必败时取分值最高的 (最慢落败)。
+ *
+ * @param tree 博弈树
+ * @param node 已展开的节点
+ * @param hand 该节点出牌方的手牌
+ * @return 子节点的下标 (没有分支时为 -1)
+ */
+int bestChild(const GameTree &tree, NodeId node, int *hand);
+
+/**
+ * @brief 交互界面当前局面的 JSON (一行，不含换行)
+ *
+ *   {"turn": "A","hand_a": [3,3,4],"hand_b": [7],"game_over": false, "winner": null,
+ *    "options": [{"id": 0, "desc": "DAN 3", "win": false}, ...], "complete": true, "best": 0}
+ *
+ * win 为子局面的出牌方是否必胜 (false 表示这是好棋)，null 表示预算内未能证明；
+ * best 为 bestChild()。开启分值分析时每个分支增加 "plies" 与 "bombs" (打出该着法起到终局的手数
+ * 与炸弹数，尚未求出时为 null)。游戏结束时 winner 为 "A" 或 "B"，options 为空且没有 complete / best。
+ * pending 为 true 时末尾增加 "pending": true，表示分析仍在进行，之后还会逐个给出结论。
+ *
+ * @param tree 博弈树
+ * @param node 当前节点 (已展开)
+ * @param a 玩家A当前手牌
+ * @param b 玩家B当前手牌
+ * @param aTurn 是否轮到 A 出牌
+ * @param pending 是否为分析开始时的局面 (结论尚未求出)
+ */
+string stateJson(const GameTree &tree, NodeId node, int *a, int *b, bool aTurn, bool pending = false);
+
+/**
+ * @brief 第 i 个分支的 JSON：{"id": i, "desc": "...", "win": true/false/null}
+ *
+ * 开启分值分析时增加 "plies": n, "bombs": k (尚未求出时为 null)。
  */
-void getTree(Node *root, int *a, int *b);
+string optionJson(const GameTree &tree, NodeId node, int i);
+
+/// 分析过程中 progress 事件的间隔 (毫秒)
+static const int PROGRESS_MS = 500;
+
+/**
+ * @brief 分析进度的 JSON：
+ *
+ *   {"event": "progress", "proven": 5, "options": 12, "nodes": 123456, "time_ms": 500.2, "knps": 246.8}
+ *
+ * proven / options 为已证明的分支数与分支总数，nodes 为本次分析已记账的节点数
+ * (每个线程每 SearchControl::POLL_NODES 个节点记账一次)。开启 --stats 时增加 "stats"
+ * (control->stats().json()，只含本次分析的统计)。
+ */
+string progressJson(const SearchControl *control, int proven, int total);
+
+/**
+ * @brief 分析交互界面的当前节点 (调用方负责 newAnalysis() 与 control->start())
+ *
+ * 用 getTree() 求解当前出牌方所有尚未证明的分支，并通过 emit 逐行输出 JSON：
+ * 先输出带 "pending": true 的局面 (stateJson)，之后每得到一个分支的结论 (或分值) 输出一行
+ *
+ *   {"event": "option", "id": 3, "desc": "DAN 5", "win": false}
+ *
+ * 开启分值分析时，所有结论之后每得到一个分值再输出一次该分支 (带 "plies" / "bombs")。
+ *
+ * 分析期间每 PROGRESS_MS 毫秒以及分析结束时输出一行 progressJson() (需要 control)。
+ * 搜索统计 (--stats) 记在 control 中，由 control->start() 清零。所有分支都已证明 (或游戏已结束) 时什么也不做。
+ *
+ * @param tree 博弈树
+ * @param node 当前节点
+ * @param a 玩家A当前手牌
+ * @param b 玩家B当前手牌
+ * @param aTurn 是否轮到 A 出牌
+ * @param control 预算与取消控制 (nullptr 表示不限)
+ * @param emit 输出一行 JSON (不含换行，nullptr 表示不输出)
+ */
+void analyzeNode(GameTree &tree, NodeId node, int *a, int *b, bool aTurn, SearchControl *control,
+                 const std::function<void(const string &)> &emit);
+
+/**
+ * @brief 节点的分支中是否有尚未证明的 (预算耗尽)
+ */
+bool hasUnknown(const GameTree &tree, NodeId node);
+
+/**
+ * @brief 节点是否需要 (继续) 分析：尚未展开、有未证明的分支，或 (开启分值分析时) 有尚无分值的已证明分支
+ */
+bool needsAnalysis(const GameTree &tree, NodeId node);
 
 /**
  * @brief 检查手牌是否为空
@@ -43,3 +195,35 @@ void getTree(Node *root, int *a, int *b);
  * @return 如果手牌为空（打完），返回 true
  */
 bool checkEmpty(int *arr);
+
+/**
+ * @brief 按内存预算分配置换表
+ * @param mb 内存上限 (MB)
+ * @return 分配成功返回 true
+ */
+bool initHash(size_t mb);
+
+/**
+ * @brief 使用持久化 (内存映射文件) 置换表
+ *
+ * 文件中已有的结果直接复用，新结果写回文件，下次启动即可命中。
+ *
+ * @param path 置换表文件路径
+ * @param mb 新建文件时的内存上限 (MB)
+ * @param err 失败时的错误信息
+ * @return 成功返回 true
+ */
+bool initHashFile(const char *path, size_t mb, string &err);
+
+/**
+ * @brief 置换表占用率
+ * @return 已占用表项比例 (0-1)
+ */
+double hashUsage();
+
+/**
+ * @brief 开始新一轮分析
+ * 
+ * 置换表中之前各轮的表项会在替换时被优先淘汰。
+ */
+void newAnalysis();
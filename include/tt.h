@@ -0,0 +1,256 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include "hand.h"
+#include "move.h"
+#include "plays.h"
+
+/**
+ * @brief 空点压缩：同时规范化 n 手牌 (规则见 PositionKey)
+ *
+ * 只去掉所有手牌都没有的点数，各手牌之间的大小与相邻关系不变。
+ */
+inline void compressGaps(Hand *h, int n) {
+    // 3-A 的字段 (2 与大小王不移动)
+    const unsigned long long RUN_FIELDS = (1ULL << Hand::shift(15)) - 1;
+    unsigned long long any = 0;
+    for (int i = 0; i < n; i++) any |= h[i].bits;
+    unsigned long long held = (any | (any >> 1) | (any >> 2)) & Hand::LSB & RUN_FIELDS;
+    if (!held) return;
+    // 要去掉的空点：前一个点数也为空的空点，以及最小持有点数之下的空点 (最大持有点数之上的无需处理)
+    unsigned long long gaps = ~held & Hand::LSB & RUN_FIELDS & ((1ULL << highBit(held)) - 1);
+    unsigned long long drop = (gaps & (gaps << 3)) | (gaps & ((held & (0 - held)) - 1));
+    // 从高到低逐个删除字段，低处的字段位置不受影响
+    while (drop) {
+        int bit = highBit(drop);
+        drop ^= 1ULL << bit;
+        unsigned long long low = (1ULL << bit) - 1;
+        for (int i = 0; i < n; i++) {
+            unsigned long long x = h[i].bits;
+            h[i].bits = (x & ~RUN_FIELDS) | (x & low) | ((x & RUN_FIELDS) >> 3 & ~low);
+        }
+    }
+}
+
+/**
+ * @brief 局面的规范形式 (置换表的 Key)
+ *
+ * 胜负只取决于点数之间的大小顺序与相邻关系 (顺子、连对、飞机要求点数相邻)，
+ * 而不取决于点数本身。因此 3-A 之间双方都没有的点数 (空点) 可以压缩：
+ *   - 最小的持有点数之下的空点全部去掉 (最小点数移到 3)；
+ *   - 两个持有点数之间的连续空点压缩为一个 (仍然隔断顺子)；
+ *   - 2 与大小王不参与连牌，位置保持不变。
+ * 例如双方只有 4 6 9 与 K 时，规范形式为 3 5 7 与 9。
+ *
+ * 上家出牌按它对当前玩家的约束编码 (见 responseCode)：能压过它的着法集合相同的出牌
+ * 共用一个编码。规范形式相同的局面胜负相同，在置换表中共用一个表项。
+ */
+struct PositionKey {
+    Hand a;                  ///< 规范化后的当前玩家手牌
+    Hand b;                  ///< 规范化后的对手手牌
+    unsigned int code;       ///< 规范化后的上家出牌编码
+    unsigned long long hash; ///< 定位桶用的哈希
+
+    PositionKey(Hand a0, Hand b0, Move p) {
+        Hand h[2] = {a0, b0};
+        compressGaps(h, 2);
+        a = h[0];
+        b = h[1];
+
+        code = responseCode(a0, p);
+
+        unsigned long long x = a.bits * 0x9E3779B97F4A7C15ULL;
+        unsigned long long y = b.bits * 0xC2B2AE3D27D4EB4FULL;
+        x ^= ((y << 23) | (y >> 41)) ^ (code * 0x165667B19E3779F9ULL);
+        x ^= x >> 29;
+        x *= 0xBF58476D1CE4E5B9ULL;
+        hash = x ^ (x >> 32);
+    }
+};
+
+/**
+ * @brief 置换表文件格式版本
+ *
+ * 表项布局或 Key 的含义 (着法编码、局面规范化) 发生变化时必须递增，
+ * 旧版本的文件会被重新初始化。
+ */
+static const unsigned int TT_FILE_VERSION = 3;
+
+/**
+ * @brief 置换表 (Transposition Table)
+ *
+ * 固定大小、开放寻址、按缓存行分桶的胜负表：
+ *   - 每个桶 64 字节，包含 4 个 16 字节的表项，一次探测只访问一条缓存行；
+ *   - 表项保存完整的规范局面 <我方手牌, 敌方手牌, 上家出牌编码> (见 PositionKey)，
+ *     因此结果是精确的，哈希只用于定位桶；
+ *   - 替换策略：命中则覆盖；否则优先使用空位；再否则淘汰上一代 (generation)
+ *     的表项或子树搜索量 (work) 最小的表项；
+ *   - 无锁：多线程直接读写表项，第一个字以 w0 ^ w1 的形式存放，读到被并发写撕裂的
+ *     表项时校验失败，按未命中处理。
+ *
+ * 表项布局：
+ *   - w0: bits 0-44 我方手牌，bits 45-63 着法编码低 19 位
+ *   - w1: bits 0-44 敌方手牌，bits 45-50 着法编码高 6 位，
+ *         bit 51 胜负，bit 52 有效位，bits 53-57 generation，bits 58-63 work
+ */
+class TransTable {
+public:
+    TransTable();
+    ~TransTable();
+    TransTable(const TransTable &) = delete;
+    TransTable &operator=(const TransTable &) = delete;
+
+    /**
+     * @brief 按内存预算分配表
+     * @param mb 内存上限 (MB)，实际大小取不超过上限的 2 的幂
+     * @return 分配成功返回 true
+     */
+    bool resize(size_t mb);
+
+    /**
+     * @brief 使用内存映射文件作为表的存储 (持久化置换表)
+     *
+     * 文件格式：4096 字节的文件头 (魔数 "NEODOUTT"、版本号、表项大小、桶数)，
+     * 随后是按缓存行排列的桶。文件已存在且版本匹配时直接复用其中的结果 (此时
+     * 表大小以文件为准)；否则按 mb 重新创建。写入直接落在共享映射上，多个进程
+     * 可以同时映射同一文件并发读写 (表项本身是无锁校验的)。
+     *
+     * @param path 文件路径
+     * @param mb 新建文件时的内存上限 (MB)
+     * @param err 失败时的错误信息
+     * @return 成功返回 true
+     */
+    bool mapFile(const char *path, size_t mb, std::string &err);
+
+    /// 是否由文件映射支持
+    bool persistent() const { return mapped; }
+
+    /// 清空所有表项
+    void clear();
+
+    /// 开始新的一轮搜索 (旧表项在替换时优先被淘汰)
+    void newSearch() { generation = (generation + 1) & 31; }
+
+    /**
+     * @brief 查表
+     * @param key 规范局面
+     * @param win 命中时写入结果
+     * @return 是否命中
+     */
+    bool probe(const PositionKey &key, bool &win) const;
+
+    /**
+     * @brief 存表
+     * @param nodes 该结果的子树搜索节点数 (用于替换策略)
+     */
+    void store(const PositionKey &key, bool win, unsigned long long nodes);
+
+    /// 表项总数
+    size_t capacity() const { return bucketCount * 4; }
+
+    /// 已占用表项比例 (0-1)
+    double occupancy() const;
+
+    /// 实际占用内存 (字节)
+    size_t bytes() const { return bucketCount * sizeof(Bucket); }
+
+private:
+    struct Entry {
+        std::atomic<unsigned long long> x0; ///< w0 ^ w1
+        std::atomic<unsigned long long> w1;
+    };
+    struct Bucket {
+        Entry e[4];
+    };
+
+    void release();
+
+    Bucket *table;
+    void *raw;
+    size_t bucketCount;
+    std::atomic<unsigned int> generation; ///< 可能与其他会话的搜索并发更新
+    bool mapped;     ///< raw 指向文件映射 (否则为 calloc 分配)
+    size_t mapBytes; ///< 映射的总字节数
+#ifdef _WIN32
+    void *fileHandle;
+    void *mapHandle;
+#endif
+};
+
+/**
+ * @brief 分值表项的边界类型
+ */
+enum class Bound {
+    EXACT, ///< 精确值
+    LOWER, ///< 下界 (搜索在 beta 处截断)
+    UPPER, ///< 上界 (所有着法都不高于 alpha)
+};
+
+/**
+ * @brief 分值置换表 (分值搜索使用，见 score.h)
+ *
+ * 与 TransTable 相同的规范局面 Key 与无锁读写，表项另外保存分值、边界类型与深度：
+ *   - 每个桶 64 字节，包含 2 个 24 字节的表项；
+ *   - 表项的两个 Key 字与 TransTable 相同，各自与数据字异或后存放，读到被并发写
+ *     撕裂的表项时校验失败；
+ *   - 数据字：bits 0-15 分值 (+32768)，bits 16-17 边界类型，bits 18-25 深度，
+ *     bits 26-30 generation，bit 31 有效位。
+ * 分值搜索把每条线都走到终局，没有搜索层数的限制，深度记录局面剩余的总张数
+ * (剩余手数的上界)，替换时优先淘汰上一代的表项，其次是深度最小的表项。
+ */
+class ScoreTable {
+public:
+    ScoreTable();
+    ~ScoreTable();
+    ScoreTable(const ScoreTable &) = delete;
+    ScoreTable &operator=(const ScoreTable &) = delete;
+
+    /**
+     * @brief 按内存预算分配表
+     * @param mb 内存上限 (MB)，实际大小取不超过上限的 2 的幂
+     * @return 分配成功返回 true
+     */
+    bool resize(size_t mb);
+
+    /// 清空所有表项
+    void clear();
+
+    /// 开始新的一轮搜索 (旧表项在替换时优先被淘汰)
+    void newSearch() { generation = (generation + 1) & 31; }
+
+    /**
+     * @brief 查表
+     * @param key 规范局面
+     * @param value 命中时写入分值
+     * @param bound 命中时写入边界类型
+     * @return 是否命中
+     */
+    bool probe(const PositionKey &key, int &value, Bound &bound) const;
+
+    /**
+     * @brief 存表
+     * @param depth 局面剩余的总张数 (用于替换策略)
+     */
+    void store(const PositionKey &key, int value, Bound bound, int depth);
+
+    /// 表项总数
+    size_t capacity() const { return bucketCount * 2; }
+
+private:
+    struct Entry {
+        std::atomic<unsigned long long> x0; ///< w0 ^ data
+        std::atomic<unsigned long long> x1; ///< w1 ^ data
+        std::atomic<unsigned long long> data;
+    };
+    struct Bucket {
+        Entry e[2];
+        unsigned long long pad[2]; ///< 补齐到一条缓存行
+    };
+
+    Bucket *table;
+    void *raw;
+    size_t bucketCount;
+    std::atomic<unsigned int> generation;
+};
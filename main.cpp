@@ -10,11 +10,84 @@
 #include <stack>
 #include <sstream>
 #include <cstring>
+#include <cstdlib>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include "./include/tree.h"
+#include "./include/search.h"
+#include "./include/json.h"
+#include "./include/batch.h"
+#include "./include/tablebase.h"
+#include "./include/three.h"
+#include "./include/server.h"
+#include "./include/bench.h"
+#include "./include/perft.h"
+#include "./include/score.h"
 using namespace std;
 
 int a[MAX_N + 5]; ///< 玩家A的手牌计数数组
 int b[MAX_N + 5]; ///< 玩家B的手牌计数数组
+int c[MAX_N + 5]; ///< 玩家C的手牌计数数组 (仅三人局面)
+int players = 2;  ///< 玩家数 (--players)
+
+SearchBudget budget;   ///< 每一步分析的预算 (--time-ms / --nodes)
+SearchControl control; ///< 当前分析的预算与取消控制
+
+/**
+ * @brief 交互输入队列
+ *
+ * 后台线程逐行读取标准输入：读到 "stop" 时立即取消正在进行的分析，
+ * 其余内容按空白拆分后排队，由交互循环依次取用。分析期间输入不会阻塞。
+ */
+std::mutex inputMu;
+std::condition_variable inputReady;
+deque<string> inputTokens;
+bool inputClosed = false;
+
+/**
+ * @brief 标准输入读取线程
+ */
+void input_loop() {
+    string line;
+    while (getline(cin, line)) {
+        istringstream ss(line);
+        string tok;
+        while (ss >> tok) {
+            if (tok == "stop") {
+                control.cancel();
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(inputMu);
+            inputTokens.push_back(tok);
+            inputReady.notify_one();
+        }
+    }
+    std::lock_guard<std::mutex> lock(inputMu);
+    inputClosed = true;
+    inputReady.notify_one();
+}
+
+/**
+ * @brief 取下一个输入 (阻塞)
+ * @return 输入结束时返回 false
+ */
+bool next_input(string &tok) {
+    std::unique_lock<std::mutex> lock(inputMu);
+    inputReady.wait(lock, [] { return inputClosed || !inputTokens.empty(); });
+    if (inputTokens.empty()) return false;
+    tok = inputTokens.front();
+    inputTokens.pop_front();
+    return true;
+}
+
+/**
+ * @brief 输出一行 JSON (分析过程中的事件)
+ */
+void emit_line(const string &line) {
+    cout << line << endl;
+}
 
 /**
  * @brief 从文件读取手牌数据
@@ -35,6 +108,7 @@ void read(FILE *fin, int *arr) {
  * 默认读取 "input.txt" 文件。
  * 第一行为玩家A的手牌，以0结束。
  * 第二行为玩家B的手牌，以0结束。
+ * 三人局面 (--players 3) 还有第三行玩家C的手牌：A 为地主，B 为地主下家，C 为地主上家。
  */
 void read_data() {
     FILE *fin = fopen("input.txt", "r");
@@ -46,33 +120,27 @@ void read_data() {
     }
     read(fin, a);
     read(fin, b);
+    if (players == 3) read(fin, c);
     if (fin != stdin) fclose(fin);
 }
 
-// Helper to escape JSON strings
-string json_escape(const string& s) {
-    string ret = "";
-    for (char c : s) {
-        if (c == '"') ret += "\\\"";
-        else if (c == '\\') ret += "\\\\";
-        else ret += c;
-    }
-    return ret;
-}
-
 /**
  * @brief 交互式输出解决方案
  * 
  * 允许用户通过命令行输入选择分支，模拟对局过程。
  * 
- * @param root 博弈树根节点
+ * 回退后改走另一个分支时，旧分支的子树被回收 (GameTree::enter)，
+ * 因此无论浏览多久，博弈树只保留当前路径上各节点的子节点。
+ * 
+ * @param tree 博弈树 (根节点已分析)
  * @param a 初始玩家A手牌
  * @param b 初始玩家B手牌
  * @param jsonMode 是否为 JSON 模式
  */
-void output_solution(Node *root, int *a, int *b, bool jsonMode) {
-    stack<Node *> st;
-    st.push(root);
+void output_solution(GameTree &tree, int *a, int *b, bool jsonMode) {
+    stack<NodeId> st;
+    st.push(GameTree::ROOT);
+    bool fresh = true; ///< 当前节点是否刚分析过 (根节点)
     
     // st.size() 的奇偶性决定当前是谁的回合
     // 初始 size=1 (root)，对应 A 出牌。
@@ -95,88 +163,29 @@ void output_solution(Node *root, int *a, int *b, bool jsonMode) {
             printf("%s : ", st.size() % 2 ? "   " : "-->"); Pai::output_arr(b);
         }
         
-        Node *node = st.top();
+        NodeId node = st.top();
         
         // 延迟展开 (Lazy Expansion):
-        // 如果当前节点没有子节点（可能是因为 Memoization 跳过了生成，或者刚走到这一步），
-        // 且游戏未结束，则现场生成子节点。
+        // 当前节点还没有子节点（刚走到这一步），或有分支在之前的预算内未能证明 (或尚无分值)，
+        // 且游戏未结束，则现场求解；已证明的分支直接复用。根节点刚由 main 分析过。
         int *curr_hand = st.size() % 2 ? a : b;
         int *opp_hand = st.size() % 2 ? b : a;
         
         // 如果手牌为空，说明上一手牌打完就赢了
         bool isWin = checkEmpty(opp_hand); // opp_hand 是刚出完牌的人
         
-        // 如果游戏没结束且需要展开
-        if (!isWin && node->child.empty()) { 
-             vector<Pai *> t = Pai::getLegalPai(curr_hand, node->p);
-             for (auto p : t) {
-                 Node *child = new Node(p, 0);
-                 p->take(curr_hand);
-                 // 调用 getTree 来计算子节点的胜负状态 (内部使用 solve 快速计算)
-                 // getTree(child, next_player, current_player)
-                 getTree(child, opp_hand, curr_hand);
-                 p->back(curr_hand);
-                 node->child.push_back(child);
-             }
+        if (!fresh && !isWin && needsAnalysis(tree, node)) { 
+             newAnalysis();
+             control.start(budget);
+             analyzeNode(tree, node, a, b, st.size() % 2, &control, jsonMode ? emit_line : nullptr);
+             if (!jsonMode && statsEnabled()) control.stats().print(stdout);
         }
+        fresh = false;
 
         if (jsonMode) {
-            // JSON Output Format
-            /*
-            {
-                "turn": "A" or "B",
-                "hand_a": [3, 3, 4, ...],
-                "hand_b": [7, ...],
-                "game_over": true/false,
-                "winner": "A" or "B" or null,
-                "options": [
-                    { "id": 0, "desc": "DAN 3", "win": false },
-                    ...
-                ]
-            }
-            */
-            cout << "{";
-            cout << "\"turn\": \"" << (st.size() % 2 ? "A" : "B") << "\",";
-            
-            // Output Hands
-            auto printHand = [](int *arr) {
-                cout << "[";
-                bool first = true;
-                for (int i = 3; i < MAX_N; i++) {
-                    for (int k = 0; k < arr[i]; k++) {
-                        if (!first) cout << ",";
-                        cout << i;
-                        first = false;
-                    }
-                }
-                cout << "]";
-            };
-            
-            cout << "\"hand_a\": "; printHand(a); cout << ",";
-            cout << "\"hand_b\": "; printHand(b); cout << ",";
-            
-            bool aWin = checkEmpty(a);
-            bool bWin = checkEmpty(b);
-            
-            if (aWin) {
-                cout << "\"game_over\": true, \"winner\": \"A\", \"options\": []";
-            } else if (bWin) {
-                cout << "\"game_over\": true, \"winner\": \"B\", \"options\": []";
-            } else {
-                cout << "\"game_over\": false, \"winner\": null, \"options\": [";
-                for (int i = 0; i < node->child.size(); i++) {
-                    if (i > 0) cout << ",";
-                    // Capture output from Pai::output() to string
-                    stringstream ss;
-                    streambuf* old_buf = cout.rdbuf(ss.rdbuf());
-                    node->child[i]->p->output();
-                    cout.rdbuf(old_buf);
-                    
-                    cout << "{\"id\": " << i << ", \"desc\": \"" << json_escape(ss.str()) << "\", \"win\": " << (node->child[i]->win ? "true" : "false") << "}";
-                }
-                cout << "]";
-            }
-            cout << "}" << endl; // End of JSON line, flush
+            // JSON 格式见 stateJson()：win 为 null 表示该分支在预算内未能证明；
+            // best 为当前最好的着法 (已证明必胜的，或未证明分支中最有希望的)。
+            cout << stateJson(tree, node, a, b, st.size() % 2) << endl; // End of JSON line, flush
         }
 
         // 用户交互循环
@@ -184,19 +193,33 @@ void output_solution(Node *root, int *a, int *b, bool jsonMode) {
         do {
             if (!jsonMode) {
                 printf("[%3d] : back\n", -1);
-                for (int i = 0; i < node->child.size(); i++) {
-                    printf("[%3d] : [%d]", i, node->child[i]->win);
-                    node->child[i]->p->output() << endl;
+                for (int i = 0; i < (int)tree[node].childCount; i++) {
+                    const Node &c = tree[tree.child(node, i)];
+                    if (c.known) printf("[%3d] : [%d]", i, c.win);
+                    else printf("[%3d] : [?]", i);
+                    if (c.scored) printf("(%d plies, %d bombs) ", c.plies, c.bombs);
+                    cout << describeMove(c.m) << endl;
+                }
+                if (scoreEnabled() && !hasUnknown(tree, node)) {
+                    cout << "best : [" << bestChild(tree, node, curr_hand) << "]" << endl;
+                }
+                if (hasUnknown(tree, node)) {
+                    int best = bestChild(tree, node, curr_hand);
+                    cout << "analysis incomplete ([?] = unknown), best guess : [" << best << "]" << endl;
                 }
                 cout << "INPUT : ";
             }
             
-            if (!(cin >> no)) { // 处理输入错误或 EOF
+            string tok;
+            if (!next_input(tok)) { // EOF
                 return;
             }
+            char *end;
+            no = (int)strtol(tok.c_str(), &end, 10);
+            if (*end) no = -2; // 非数字输入
             
             if (no == -1) break;
-            if (no >= 0 && no < (int)node->child.size()) break;
+            if (no >= 0 && no < (int)tree[node].childCount) break;
             if (!jsonMode) cout << "Invalid input!" << endl;
         } while(1);
         
@@ -204,36 +227,365 @@ void output_solution(Node *root, int *a, int *b, bool jsonMode) {
             // 回退
             if (st.size() > 1) { // 根节点不能回退
                 st.pop();
-                node->p->back(st.size() % 2 ? a : b);
+                tree[node].m.back(st.size() % 2 ? a : b);
             }
         }
         else {
             // 前进
             // 扣除手牌
             // 当前是谁出牌？ size % 2 ? a : b。
-            node->child[no]->p->take(st.size() % 2 ? a : b);
-            st.push(node->child[no]);
+            NodeId next = tree.enter(node, no);
+            tree[next].m.take(st.size() % 2 ? a : b);
+            st.push(next);
+        }
+    }
+}
+
+/**
+ * @brief 三人局面的交互
+ *
+ * 与 output_solution 相同的交互方式 (输入编号前进，-1 回退)，局面为 A (地主)、
+ * B (地主下家)、C (地主上家) 三手牌。每个着法的胜负是对当前出牌者所在阵营而言的。
+ * JSON 模式在两人格式的基础上增加 "hand_c"、"last" (需要压过的牌，自由出牌时为 null)，
+ * 结束时增加 "winning_team" ("landlord" 或 "peasants")。
+ *
+ * @param jsonMode 是否为 JSON 模式
+ */
+void output_three(bool jsonMode) {
+    static const char SEAT[] = "ABC";
+    vector<ThreeState> st;
+    st.push_back(ThreeState::deal(Hand::fromArray(a), Hand::fromArray(b), Hand::fromArray(c)));
+
+    while (!st.empty()) {
+        ThreeState s = st.back();
+        int done = s.finished();
+        if (!jsonMode) {
+            if (done >= 0) {
+                printf("%c Wins! (%s)\n", SEAT[done], done == 0 ? "landlord" : "peasants");
+                return;
+            }
+            for (int i = 0; i < SEATS; i++) {
+                int arr[MAX_N + 5] = {0};
+                s.hand[i].toArray(arr);
+                printf("%s %c : ", s.turn == i ? "-->" : "   ", SEAT[i]);
+                Pai::output_arr(arr);
+            }
+            if (!s.last.isPass()) cout << "to beat : " << describeMove(s.last) << endl;
+        }
+
+        // 每到一个局面都重新分析 (已证明的结果在搜索器的置换表中，回退后再次到达时直接命中)
+        vector<Move> moves;
+        vector<Outcome> result;
+        if (done < 0) {
+            control.start(budget);
+            genLegalMoves(s.hand[s.turn], s.last, moves);
+            for (Move m : moves) result.push_back(solveThreeMove(s, m, &control));
+        }
+        // 当前最好的着法：已证明必胜的优先，其次是第一个尚未证明的，全部必败时取第一个
+        bool complete = true;
+        int best = -1, open = -1;
+        for (size_t i = 0; i < result.size(); i++) {
+            if (result[i] == Outcome::WIN && best < 0) best = (int)i;
+            if (result[i] == Outcome::UNKNOWN) {
+                complete = false;
+                if (open < 0) open = (int)i;
+            }
+        }
+        if (best < 0) best = open >= 0 ? open : (moves.empty() ? -1 : 0);
+
+        if (jsonMode) {
+            cout << "{\"turn\": \"" << SEAT[s.turn] << "\", ";
+            cout << "\"hand_a\": " << json_hand(s.hand[0]) << ", ";
+            cout << "\"hand_b\": " << json_hand(s.hand[1]) << ", ";
+            cout << "\"hand_c\": " << json_hand(s.hand[2]) << ", ";
+            if (s.last.isPass()) cout << "\"last\": null, ";
+            else cout << "\"last\": \"" << json_escape(describeMove(s.last)) << "\", ";
+            if (done >= 0) {
+                cout << "\"game_over\": true, \"winner\": \"" << SEAT[done] << "\", \"winning_team\": \""
+                     << (done == 0 ? "landlord" : "peasants") << "\", \"options\": []";
+            } else {
+                cout << "\"game_over\": false, \"winner\": null, \"options\": [";
+                for (size_t i = 0; i < moves.size(); i++) {
+                    if (i > 0) cout << ",";
+                    const char *win = result[i] == Outcome::UNKNOWN ? "null" : (result[i] == Outcome::WIN ? "true" : "false");
+                    cout << "{\"id\": " << i << ", \"desc\": \"" << json_escape(describeMove(moves[i]))
+                         << "\", \"win\": " << win << "}";
+                }
+                cout << "], \"complete\": " << (complete ? "true" : "false") << ", \"best\": " << best;
+            }
+            cout << "}" << endl;
+        }
+
+        int no;
+        do {
+            if (!jsonMode) {
+                printf("[%3d] : back\n", -1);
+                for (size_t i = 0; i < moves.size(); i++) {
+                    if (result[i] == Outcome::UNKNOWN) printf("[%3d] : [?]", (int)i);
+                    else printf("[%3d] : [%d]", (int)i, result[i] == Outcome::WIN);
+                    cout << describeMove(moves[i]) << endl;
+                }
+                if (!complete) cout << "analysis incomplete ([?] = unknown), best guess : [" << best << "]" << endl;
+                cout << "INPUT : ";
+            }
+
+            string tok;
+            if (!next_input(tok)) return; // EOF
+            char *end;
+            no = (int)strtol(tok.c_str(), &end, 10);
+            if (*end) no = -2; // 非数字输入
+
+            if (no == -1) break;
+            if (no >= 0 && no < (int)moves.size()) break;
+            if (!jsonMode) cout << "Invalid input!" << endl;
+        } while (1);
+
+        if (no == -1) {
+            if (st.size() > 1) st.pop_back(); // 根节点不能回退
+        } else {
+            st.push_back(s.after(moves[no]));
         }
     }
 }
 
+/**
+ * @brief 打印命令行用法
+ */
+void usage(const char *prog) {
+    printf("usage: %s [--json] [--hash-mb N] [--tt-file PATH] [--tb PATH] [--engine dfs|pn] [--threads N]\n", prog);
+    printf("          [--time-ms N] [--nodes N] [--players 2|3] [--batch [FILE]] [--server [PATH]] [--session-mb N]\n");
+    printf("          [--stats] [--score]\n");
+    printf("       %s --tb-build N PATH [--threads N]\n", prog);
+    printf("       %s --bench FILE [--repeat N] [--hash-mb N] [--engine dfs|pn] [--tb PATH]\n", prog);
+    printf("       %s --perft N [FILE] [--perft-gen fast|ref|both]\n", prog);
+    printf("  --json       JSON 交互模式 (供 gui.py 使用)\n");
+    printf("  --hash-mb N  置换表内存上限 (MB)，默认 256\n");
+    printf("  --tt-file PATH 持久化置换表文件 (内存映射，可跨进程、跨次运行复用结果)\n");
+    printf("  --tb PATH    加载残局库，搜索时直接查询双方都不超过 N 张的自由出牌局面\n");
+    printf("  --tb-build N PATH 生成每方不超过 N 张的残局库并写入 PATH\n");
+    printf("  --engine E   搜索引擎：dfs (深度优先，默认) 或 pn (证明数搜索，单线程)\n");
+    printf("  --threads N  搜索线程数 (共享同一张置换表)，默认 1\n");
+    printf("  --time-ms N  交互模式每一步分析的时间上限 (毫秒)，超出后未证明的着法显示为未知\n");
+    printf("  --nodes N    交互模式每一步分析的节点数上限\n");
+    printf("               分析过程中输入 stop 可随时中断\n");
+    printf("  --players N  玩家数：2 (默认) 或 3 (地主 A 对农民 B、C，输入三手牌，\n");
+    printf("               单线程、不使用 --engine / --tb / --tt-file)\n");
+    printf("  --batch FILE 批量求解 FILE (省略或为 - 时读标准输入) 中的所有局面，\n");
+    printf("               每个局面输出一行 JSON；--threads 指定工作线程数\n");
+    printf("  --server [PATH] 常驻求解服务：置换表跨局保留，按行协议 (new/play/back/show/close/\n");
+    printf("               stats/stop/quit) 同时服务多个会话；PATH 为 Unix socket，省略时用标准输入/输出\n");
+    printf("  --session-mb N 服务模式所有会话博弈树的内存上限 (MB)，超出时淘汰最久未用的会话，默认 64\n");
+    printf("  --stats      搜索统计：节点、查表、截断、各牌型着法数、深度分布与各阶段耗时。交互模式每次分析后打印，\n");
+    printf("               JSON / 服务模式附在 progress 事件中，批量模式结束时输出到标准错误，基准测试附在每个局面中\n");
+    printf("  --score      分值分析：已证明的着法另外给出到终局的手数与炸弹数 (胜方最快出完、负方最慢落败)，\n");
+    printf("               分值表占 --hash-mb 之外的四分之一；仅两人交互 / JSON / 服务模式\n");
+    printf("  --bench FILE 基准测试：单线程、每次使用新的置换表求解 FILE 中的局面 (格式见 bench/corpus.txt)，\n");
+    printf("               每个局面输出一行 JSON (耗时、节点速度、查表命中率、峰值内存)，结论与预期不符时退出码为 2\n");
+    printf("  --repeat N   基准测试中每个局面的求解次数 (耗时取中位数)，默认 3\n");
+    printf("  --perft N [FILE] 着法生成器校验：统计 FILE (省略或为 - 时读标准输入) 中每个局面 1..N 手的\n");
+    printf("               出牌序列数、最后一手的牌型分布与生成速度，每个深度输出一行 JSON\n");
+    printf("  --perft-gen G 生成器：fast (MoveGen)、ref (Pai::getLegalPai) 或 both (默认，比较两者，\n");
+    printf("               不一致时列出出错的局面，退出码为 2)\n");
+}
+
 int main(int argc, char** argv){
     bool jsonMode = false;
-    if (argc > 1 && strcmp(argv[1], "--json") == 0) {
-        jsonMode = true;
+    bool batchMode = false;
+    bool serverMode = false;
+    ServerOptions server;
+    const char *batchFile = nullptr;
+    const char *benchFile = nullptr;
+    const char *perftFile = nullptr;
+    int perftDepth = 0;
+    PerftGen perftGen = PerftGen::BOTH;
+    int repeat = 3;
+    const char *ttFile = nullptr;
+    const char *tbFile = nullptr;
+    int tbBuild = 0;
+    size_t hashMb = 256;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            jsonMode = true;
+        } else if (strcmp(argv[i], "--hash-mb") == 0 && i + 1 < argc) {
+            hashMb = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--tt-file") == 0 && i + 1 < argc) {
+            ttFile = argv[++i];
+        } else if (strcmp(argv[i], "--tb") == 0 && i + 1 < argc) {
+            tbFile = argv[++i];
+        } else if (strcmp(argv[i], "--tb-build") == 0 && i + 2 < argc) {
+            tbBuild = atoi(argv[++i]);
+            tbFile = argv[++i];
+        } else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "pn") == 0) setEngine(Engine::PN);
+            else if (strcmp(argv[i], "dfs") == 0) setEngine(Engine::DFS);
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--time-ms") == 0 && i + 1 < argc) {
+            budget.timeMs = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+            budget.nodes = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            setThreads(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--players") == 0 && i + 1 < argc) {
+            players = atoi(argv[++i]);
+            if (players != 2 && players != 3) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            batchMode = true;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) batchFile = argv[++i];
+        } else if (strcmp(argv[i], "--server") == 0) {
+            serverMode = true;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) server.socketPath = argv[++i];
+        } else if (strcmp(argv[i], "--session-mb") == 0 && i + 1 < argc) {
+            server.sessionMb = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            enableStats(true);
+        } else if (strcmp(argv[i], "--score") == 0) {
+            enableScore(true);
+        } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            benchFile = argv[++i];
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--perft") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            perftDepth = atoi(argv[++i]);
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) perftFile = argv[++i];
+        } else if (strcmp(argv[i], "--perft-gen") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "fast") == 0) perftGen = PerftGen::FAST;
+            else if (strcmp(argv[i], "ref") == 0) perftGen = PerftGen::REF;
+            else if (strcmp(argv[i], "both") == 0) perftGen = PerftGen::BOTH;
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (perftDepth) {
+        FILE *fin = stdin;
+        if (perftFile && strcmp(perftFile, "-") != 0) {
+            fin = fopen(perftFile, "r");
+            if (!fin) {
+                fprintf(stderr, "cannot open %s\n", perftFile);
+                return 1;
+            }
+        }
+        int ret = runPerft(fin, perftDepth, perftGen);
+        if (fin != stdin) fclose(fin);
+        return ret;
+    }
+
+    if (tbBuild) {
+        Tablebase tb;
+        string err;
+        if (!tb.build(tbBuild, threadCount(), err) || !tb.save(tbFile, err)) {
+            fprintf(stderr, "%s\n", err.c_str());
+            return 1;
+        }
+        fprintf(stderr, "tablebase: %d cards, %zu bytes written to %s\n", tb.cards(), tb.bytes(), tbFile);
+        return 0;
+    }
+
+    if (tbFile) {
+        string err;
+        if (!tablebase().load(tbFile, err)) {
+            fprintf(stderr, "%s\n", err.c_str());
+            return 1;
+        }
+    }
+
+    if (benchFile) {
+        FILE *fin = fopen(benchFile, "r");
+        if (!fin) {
+            fprintf(stderr, "cannot open %s\n", benchFile);
+            return 1;
+        }
+        int ret = runBench(fin, repeat, hashMb);
+        fclose(fin);
+        return ret;
+    }
+
+    if (ttFile) {
+        string err;
+        if (!initHashFile(ttFile, hashMb, err)) {
+            fprintf(stderr, "%s\n", err.c_str());
+            return 1;
+        }
+    }
+
+    if (batchMode) {
+        FILE *fin = stdin;
+        if (batchFile && strcmp(batchFile, "-") != 0) {
+            fin = fopen(batchFile, "r");
+            if (!fin) {
+                fprintf(stderr, "cannot open %s\n", batchFile);
+                return 1;
+            }
+        }
+        int ret = runBatch(fin, threadCount(), hashMb, ttFile ? &sharedTable() : nullptr, players);
+        if (fin != stdin) fclose(fin);
+        if (statsEnabled()) totalStats().print(stderr);
+        return ret;
+    }
+
+    if (serverMode && players == 3) {
+        fprintf(stderr, "--server supports two players only\n");
+        return 1;
+    }
+
+    if (scoreEnabled() && players == 3) {
+        fprintf(stderr, "--score supports two players only\n");
+        return 1;
+    }
+
+    if (players == 3 ? !initThree(hashMb) : !ttFile && !initHash(hashMb)) {
+        fprintf(stderr, "cannot allocate %zu MB for the hash table\n", hashMb);
+        return 1;
+    }
+
+    if (scoreEnabled() && !scoreTable().resize(hashMb / 4 ? hashMb / 4 : 1)) {
+        fprintf(stderr, "cannot allocate %zu MB for the score table\n", hashMb / 4);
+        return 1;
+    }
+
+    if (serverMode) {
+        server.budget = budget;
+        return runServer(server);
     }
 
     read_data();
     if (!jsonMode) cout << "read data done ......" << endl;
+
+    // 分析期间继续读取输入，以便随时用 stop 中断
+    std::thread(input_loop).detach();
+
+    if (players == 3) {
+        output_three(jsonMode);
+        return 0;
+    }
     
-    Node *rt = new Node;
+    GameTree tree;
     if (!jsonMode) cout << "analysis start ......" << endl;
     
     // 初始分析：计算根节点的胜负状态
-    getTree(rt, a, b);
+    newAnalysis();
+    control.start(budget);
+    analyzeNode(tree, GameTree::ROOT, a, b, true, &control, jsonMode ? emit_line : nullptr);
     
-    if (!jsonMode) cout << "analysis done  ......" << endl;
+    if (!jsonMode) {
+        cout << (control.stopped() ? "analysis stopped ..." : "analysis done  ......") << endl;
+        printf("hash usage : %.1f%% of %zu MB\n", hashUsage() * 100, sharedTable().bytes() >> 20);
+        if (statsEnabled()) control.stats().print(stdout);
+    }
     
-    output_solution(rt, a, b, jsonMode);    
+    output_solution(tree, a, b, jsonMode);    
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,232 @@
+/**
+ * @file batch.cc
+ * @brief 批量求解：流式读取局面、线程池求解、JSONL 输出
+ */
+
+#include "../include/batch.h"
+#include "../include/search.h"
+#include "../include/pn.h"
+#include "../include/three.h"
+#include "../include/json.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// 待求解队列的容量上限 (读取线程在队列满时等待，避免一次性读入全部输入)
+static const size_t QUEUE_LIMIT = 1024;
+
+/**
+ * @brief 一个待求解的局面
+ */
+struct BatchJob {
+    long long id;
+    Hand a, b, c; ///< c 仅用于三人局面
+    string error; ///< 非空表示输入不合法
+};
+
+/**
+ * @brief 读取一手牌 (以 0 结束)
+ *
+ * 先按空白读出到 0 为止的所有记号，再用与服务模式、基准测试相同的 parseHand() 校验，
+ * 因此格式错误的手牌也读到了结尾的 0，不影响之后的局面。已有错误时不覆盖。
+ *
+ * @return 读到 EOF 且没有任何记号时返回 false
+ */
+static bool readHand(FILE *in, Hand &h, string &error) {
+    string text;
+    char tok[64];
+    bool any = false;
+    while (fscanf(in, "%63s", tok) == 1) {
+        any = true;
+        text += tok;
+        text += ' ';
+        char *end;
+        if (strtol(tok, &end, 10) == 0 && *end == '\0' && end != tok) break;
+    }
+    if (!any) return false;
+
+    int cnt[MAX_N + 5] = {0};
+    istringstream ss(text);
+    string e;
+    if (parseHand(ss, cnt, e)) h = Hand::fromArray(cnt);
+    else if (error.empty()) error = e;
+    return true;
+}
+
+/**
+ * @brief 求解单个局面并生成 JSON 行
+ * @param ps 工作线程的证明数搜索器 (nullptr 表示使用深度优先引擎)
+ */
+static string solveJob(const BatchJob &job, TransTable &table, PnSearcher *ps) {
+    string line = "{\"id\": " + to_string(job.id);
+    if (!job.error.empty()) {
+        return line + ", \"error\": \"" + json_escape(job.error) + "\"}";
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    table.newSearch();
+    Searcher s(0, nullptr, &table);
+    unsigned long long before = ps ? ps->nodes() : 0;
+    unsigned long long nodes = 0;
+
+    bool win = false;
+    vector<Move> winning;
+    if (!job.b.empty()) {
+        vector<Move> moves;
+        genLegalMoves(job.a, Move::pass(), moves);
+        // 根节点逐一求解所有着法，以列出全部必胜的第一手
+        for (Move m : moves) {
+            Hand next = job.a;
+            m.take(next);
+            bool oppWin;
+            if (ps) {
+                oppWin = ps->solve(job.b, next, m);
+            } else {
+                oppWin = s.solve(job.b, next, m);
+            }
+            if (!oppWin) winning.push_back(m);
+        }
+        nodes = ps ? ps->nodes() - before : s.nodes();
+        win = !winning.empty();
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    line += ", \"hand_a\": " + json_hand(job.a) + ", \"hand_b\": " + json_hand(job.b);
+    line += string(", \"win\": ") + (win ? "true" : "false") + ", \"winning_moves\": [";
+    for (size_t i = 0; i < winning.size(); i++) {
+        if (i) line += ", ";
+        line += "\"" + json_escape(describeMove(winning[i])) + "\"";
+    }
+    char tail[96];
+    snprintf(tail, sizeof(tail), "], \"nodes\": %llu, \"time_ms\": %.3f}", nodes, ms);
+    return line + tail;
+}
+
+/**
+ * @brief 求解单个三人局面 (地主先出) 并生成 JSON 行
+ */
+static string solveJob3(const BatchJob &job, ThreeSearcher &s) {
+    string line = "{\"id\": " + to_string(job.id);
+    if (!job.error.empty()) {
+        return line + ", \"error\": \"" + json_escape(job.error) + "\"}";
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    unsigned long long before = s.nodes();
+    ThreeState root = ThreeState::deal(job.a, job.b, job.c);
+    vector<Move> winning;
+    if (root.finished() < 0) {
+        vector<Move> moves;
+        genLegalMoves(job.a, Move::pass(), moves);
+        // 根节点逐一求解所有着法，以列出全部必胜的第一手
+        for (Move m : moves) {
+            ThreeState next = root.after(m);
+            // 下家是农民：农民一方必败即地主必胜
+            if (next.hand[0].empty() || !s.solve(next)) winning.push_back(m);
+        }
+    }
+    bool win = !winning.empty();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    line += ", \"hand_a\": " + json_hand(job.a) + ", \"hand_b\": " + json_hand(job.b);
+    line += ", \"hand_c\": " + json_hand(job.c);
+    line += string(", \"win\": ") + (win ? "true" : "false") + ", \"winning_moves\": [";
+    for (size_t i = 0; i < winning.size(); i++) {
+        if (i) line += ", ";
+        line += "\"" + json_escape(describeMove(winning[i])) + "\"";
+    }
+    char tail[96];
+    snprintf(tail, sizeof(tail), "], \"nodes\": %llu, \"time_ms\": %.3f}", s.nodes() - before, ms);
+    return line + tail;
+}
+
+int runBatch(FILE *in, int workers, size_t hashMb, TransTable *shared, int players) {
+    if (workers < 1) workers = 1;
+    size_t perWorker = hashMb / workers;
+    if (perWorker < 1) perWorker = 1;
+    const bool three = players == 3;
+    if (three) shared = nullptr;
+
+    vector<std::unique_ptr<ThreeSearcher>> threeSearchers;
+    for (int i = 0; three && i < workers; i++) {
+        threeSearchers.emplace_back(new ThreeSearcher(perWorker));
+        if (!threeSearchers.back()->ready()) {
+            fprintf(stderr, "cannot allocate %zu MB for the hash table\n", perWorker);
+            return 1;
+        }
+    }
+
+    // pn 引擎：每个线程的份额由置换表与 pn / dn 表平分
+    const bool pn = !three && engine() == Engine::PN;
+    size_t tableMb = pn ? std::max<size_t>(perWorker / 2, 1) : perWorker;
+    vector<TransTable> tables(shared || three ? 0 : workers);
+    for (auto &t : tables) {
+        if (!t.resize(tableMb)) {
+            fprintf(stderr, "cannot allocate %zu MB for the hash table\n", tableMb);
+            return 1;
+        }
+    }
+    // pn / dn 表以完整局面为 Key，表项在局面之间始终有效，整个批次复用
+    vector<std::unique_ptr<PnSearcher>> pnSearchers;
+    for (int i = 0; pn && i < workers; i++) {
+        pnSearchers.emplace_back(new PnSearcher(nullptr, shared ? shared : &tables[i], std::max<size_t>(perWorker - tableMb, 1)));
+    }
+
+    std::mutex mu;
+    std::condition_variable notEmpty, notFull;
+    std::deque<BatchJob> queue;
+    bool done = false;
+    std::mutex outMu;
+
+    auto worker = [&](int id) {
+        for (;;) {
+            BatchJob job;
+            {
+                std::unique_lock<std::mutex> lock(mu);
+                notEmpty.wait(lock, [&] { return done || !queue.empty(); });
+                if (queue.empty()) return;
+                job = queue.front();
+                queue.pop_front();
+            }
+            notFull.notify_one();
+            string line = three ? solveJob3(job, *threeSearchers[id]) : solveJob(job, shared ? *shared : tables[id], pn ? pnSearchers[id].get() : nullptr);
+            std::lock_guard<std::mutex> lock(outMu);
+            fputs(line.c_str(), stdout);
+            fputc('\n', stdout);
+            fflush(stdout);
+        }
+    };
+
+    vector<std::thread> pool;
+    for (int i = 0; i < workers; i++) pool.emplace_back(worker, i);
+
+    for (long long id = 0;; id++) {
+        BatchJob job;
+        job.id = id;
+        job.a.bits = job.b.bits = job.c.bits = 0;
+        if (!readHand(in, job.a, job.error)) break;
+        // 输入在局面中途结束：报告错误而不是把缺少的手牌当作空牌求解 (已有错误时保留先出现的)
+        bool complete = readHand(in, job.b, job.error);
+        if (!complete && job.error.empty()) job.error = "missing second hand";
+        if (complete && three && !readHand(in, job.c, job.error) && job.error.empty()) job.error = "missing third hand";
+        std::unique_lock<std::mutex> lock(mu);
+        notFull.wait(lock, [&] { return queue.size() < QUEUE_LIMIT; });
+        queue.push_back(job);
+        notEmpty.notify_one();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        done = true;
+    }
+    notEmpty.notify_all();
+    for (auto &t : pool) t.join();
+    return 0;
+}
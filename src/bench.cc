@@ -0,0 +1,174 @@
+/**
+ * @file bench.cc
+ * @brief 基准测试：固定局面集的重复求解与性能统计
+ */
+
+#include "../include/bench.h"
+#include "../include/search.h"
+#include "../include/pn.h"
+#include "../include/json.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+/**
+ * @brief 一次求解的统计
+ */
+struct BenchRun {
+    bool win;
+    unsigned long long nodes;
+    unsigned long long probes;
+    unsigned long long hits;
+    double ms;
+    long ttKb; ///< 求解后置换表已占用的内存 (KB，按抽样的占用率估算)
+};
+
+/**
+ * @brief 分类 (或全部局面) 的合计
+ */
+struct BenchTotal {
+    int positions = 0;
+    int failed = 0;
+    unsigned long long nodes = 0;
+    unsigned long long probes = 0;
+    unsigned long long hits = 0;
+    double ms = 0; ///< 各局面耗时中位数之和
+};
+
+/**
+ * @brief 进程至今的峰值常驻内存 (KB)，不支持的平台返回 -1
+ */
+static long peakRssKb() {
+#ifndef _WIN32
+    rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+#ifdef __APPLE__
+        return ru.ru_maxrss >> 10; // macOS 以字节为单位
+#else
+        return ru.ru_maxrss;
+#endif
+    }
+#endif
+    return -1;
+}
+
+/**
+ * @brief 使用新分配的置换表求解一次 A 先自由出牌的局面
+ * @return 置换表分配失败时返回 false
+ */
+static bool solveOnce(Hand a, Hand b, size_t hashMb, BenchRun &run) {
+    TransTable table;
+    if (!table.resize(hashMb)) return false;
+
+    auto start = std::chrono::steady_clock::now();
+    if (engine() == Engine::PN) {
+        PnSearcher s(nullptr, &table);
+        run.win = s.solve(a, b, Move::pass());
+        run.nodes = s.nodes();
+        run.probes = s.tableProbes();
+        run.hits = s.tableHits();
+    } else {
+        Searcher s(0, nullptr, &table);
+        run.win = s.solve(a, b, Move::pass());
+        run.nodes = s.nodes();
+        run.probes = s.tableProbes();
+        run.hits = s.tableHits();
+    }
+    run.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    run.ttKb = (long)(table.occupancy() * table.bytes() / 1024);
+    return true;
+}
+
+static string totalJson(const BenchTotal &t) {
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "{\"positions\": %d, \"failed\": %d, \"nodes\": %llu, \"time_ms\": %.3f, \"knps\": %.1f, \"tt_hit_rate\": %.4f}",
+             t.positions, t.failed, t.nodes, t.ms, t.ms > 0 ? t.nodes / t.ms : 0.0,
+             t.probes ? (double)t.hits / t.probes : 0.0);
+    return buf;
+}
+
+int runBench(FILE *in, int repeat, size_t hashMb) {
+    if (repeat < 1) repeat = 1;
+    BenchTotal all;
+    std::map<string, BenchTotal> categories;
+    vector<string> order; ///< 分类按首次出现的顺序输出
+
+    char buf[1024];
+    for (int lineNo = 1, id = 0; fgets(buf, sizeof(buf), in); lineNo++) {
+        istringstream ss(buf);
+        string category, expected;
+        if (!(ss >> category) || category[0] == '#') continue;
+
+        int ca[MAX_N + 5] = {0}, cb[MAX_N + 5] = {0};
+        string error;
+        bool valid = (ss >> expected) && (expected == "win" || expected == "loss");
+        if (!valid) error = "expected verdict must be win or loss";
+        else valid = parseHand(ss, ca, error) && parseHand(ss, cb, error);
+        if (!valid) {
+            fprintf(stderr, "line %d: %s\n", lineNo, error.c_str());
+            return 1;
+        }
+        Hand a = Hand::fromArray(ca), b = Hand::fromArray(cb);
+
+        // 节点数与查表次数每次都相同 (新的置换表、单线程)，耗时取中位数
+        BenchRun run;
+        vector<double> times;
+        for (int r = 0; r < repeat; r++) {
+            resetStats();
+            if (!solveOnce(a, b, hashMb, run)) {
+                fprintf(stderr, "cannot allocate %zu MB for the hash table\n", hashMb);
+                return 1;
+            }
+            times.push_back(run.ms);
+        }
+        std::sort(times.begin(), times.end());
+        double median = times[times.size() / 2];
+        bool want = expected == "win";
+        bool ok = run.win == want;
+
+        string line = "{\"id\": " + to_string(id++) + ", \"category\": \"" + json_escape(category) + "\"";
+        line += string(", \"expected\": ") + (want ? "true" : "false") + ", \"win\": " + (run.win ? "true" : "false");
+        line += string(", \"ok\": ") + (ok ? "true" : "false");
+        char tail[256];
+        snprintf(tail, sizeof(tail),
+                 ", \"nodes\": %llu, \"time_ms\": %.3f, \"min_ms\": %.3f, \"knps\": %.1f, \"tt_probes\": %llu, \"tt_hit_rate\": %.4f",
+                 run.nodes, median, times[0], median > 0 ? run.nodes / median : 0.0, run.probes,
+                 run.probes ? (double)run.hits / run.probes : 0.0);
+        line += tail;
+        line += ", \"tt_kb\": " + to_string(run.ttKb);
+        if (statsEnabled()) line += ", \"stats\": " + totalStats().json();
+        line += "}";
+        puts(line.c_str());
+        fflush(stdout);
+
+        if (!categories.count(category)) order.push_back(category);
+        for (BenchTotal *t : {&all, &categories[category]}) {
+            t->positions++;
+            t->failed += !ok;
+            t->nodes += run.nodes;
+            t->probes += run.probes;
+            t->hits += run.hits;
+            t->ms += median;
+        }
+    }
+
+    long rss = peakRssKb();
+    string summary = "{\"summary\": true, \"engine\": \"" + string(engine() == Engine::PN ? "pn" : "dfs") + "\"";
+    summary += ", \"repeat\": " + to_string(repeat) + ", \"hash_mb\": " + to_string(hashMb);
+    summary += ", \"total\": " + totalJson(all) + ", \"categories\": {";
+    for (size_t i = 0; i < order.size(); i++) {
+        if (i) summary += ", ";
+        summary += "\"" + json_escape(order[i]) + "\": " + totalJson(categories[order[i]]);
+    }
+    summary += "}, \"peak_rss_kb\": " + (rss < 0 ? string("null") : to_string(rss)) + "}";
+    puts(summary.c_str());
+    return all.failed ? 2 : 0;
+}
@@ -0,0 +1,36 @@
+/**
+ * @file budget.cc
+ * @brief 搜索预算与取消
+ */
+
+#include "../include/budget.h"
+
+void SearchControl::start(const SearchBudget &b) {
+    budget = b;
+    begin = std::chrono::steady_clock::now();
+    used.store(0, std::memory_order_relaxed);
+    halted.store(false, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(statsMu);
+    total = SearchStats();
+}
+
+bool SearchControl::charge(unsigned long long n) {
+    unsigned long long total = used.fetch_add(n, std::memory_order_relaxed) + n;
+    if (budget.nodes && total >= budget.nodes) cancel();
+    else if (budget.timeMs && elapsedMs() >= (double)budget.timeMs) cancel();
+    return stopped();
+}
+
+void SearchControl::addStats(const SearchStats &s) {
+    std::lock_guard<std::mutex> lock(statsMu);
+    total.add(s);
+}
+
+SearchStats SearchControl::stats() const {
+    std::lock_guard<std::mutex> lock(statsMu);
+    return total;
+}
+
+double SearchControl::elapsedMs() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
@@ -0,0 +1,212 @@
+/**
+ * @file eval.cc
+ * @brief 静态胜负判定：一手出完与控制分析
+ */
+
+#include "../include/eval.h"
+
+/// 大小王所在字段
+static const unsigned long long JOKERS = (1ULL << Hand::shift(16)) | (1ULL << Hand::shift(17));
+/// 点数 3..2 (不含王) 的字段
+static const unsigned long long NO_JOKER = Hand::LSB & ~JOKERS;
+
+/// 点数严格大于 r 的字段掩码 (展开形式)
+static inline unsigned long long above(int r) {
+    return Hand::LSB & ~((1ULL << (Hand::shift(r) + 3)) - 1);
+}
+
+/// 手牌中每个点数的张数都是偶数
+static inline bool allEven(Hand h) {
+    return (h.bits & Hand::LSB) == 0;
+}
+
+/**
+ * @brief 若 a 在某个点数上正好是连续的 run 张、且全部张数相同，判断能否作为连牌出完
+ */
+static bool runFinish(Hand a, Move p, int n) {
+    unsigned long long g1 = a.ge1();
+    int ranks = popCount(g1);
+    int unit = n / ranks;
+    if (unit * ranks != n || unit > 3) return false;
+    int lo = fieldRank(lowBit(g1));
+    int hi = fieldRank(highBit(g1));
+    if (hi > 14 || hi - lo + 1 != ranks || a.bits != kRunTable.bits[lo][ranks] * unit) return false;
+
+    Move m;
+    if (unit == 1 && ranks >= 5) m = Move::make(PaiType::SHUNZI_T, lo, ranks, 0, 0);
+    else if (unit == 2 && ranks >= 3) m = Move::make(PaiType::LIANDUI_T, lo, ranks, 0, 0);
+    else if (unit == 3 && ranks >= 2 && ranks <= 6) m = Move::make(PaiType::FEIJI_T, lo, ranks, 0, 0);
+    else return false;
+    return m > p;
+}
+
+bool oneMoveFinish(Hand a, Move p) {
+    const int n = a.size();
+    const unsigned long long g1 = a.ge1();
+
+    // 单一点数：单张、对子、三张、炸弹
+    if ((g1 & (g1 - 1)) == 0) {
+        int r = fieldRank(lowBit(g1));
+        static const PaiType single[5] = {PaiType::PASS_T, PaiType::DAN_T, PaiType::DUIZI_T,
+                                          PaiType::SANDAI_T, PaiType::ZHADAN_T};
+        return Move::make(single[n], r, 1, 0, 0) > p;
+    }
+
+    // 王炸
+    if (a.bits == JOKERS) return Move::make(PaiType::WANGZHA_T, 16, 2, 0, 0) > p;
+
+    // 顺子、连对、不带翅膀的飞机
+    if (runFinish(a, p, n)) return true;
+
+    const unsigned long long g3 = a.ge3();
+
+    // 三带一 / 三带一对
+    if ((n == 4 || n == 5) && g3 && (g3 & (g3 - 1)) == 0) {
+        int bit = lowBit(g3);
+        Hand rest;
+        rest.bits = a.bits - (3ULL << bit);
+        if (n == 4 && (rest.ge1() & (1ULL << bit)) == 0) {
+            if (Move::make(PaiType::SANDAI_T, fieldRank(bit), 1, 1, rest.bits) > p) return true;
+        }
+        if (n == 5 && popCount(rest.ge1()) == 1 && rest.ge2() && !(rest.ge1() & (1ULL << bit))) {
+            if (Move::make(PaiType::SANDAI_T, fieldRank(bit), 1, 2, rest.bits) > p) return true;
+        }
+    }
+
+    // 四带二 (带牌不能是王)
+    if ((n == 6 || n == 8) && !(a.bits & (7ULL << Hand::shift(16))) && !(a.bits & (7ULL << Hand::shift(17)))) {
+        for (unsigned long long x = a.ge4(); x; x &= x - 1) {
+            int bit = lowBit(x);
+            Hand rest;
+            rest.bits = a.bits - (4ULL << bit);
+            Move m;
+            if (n == 6) m = Move::make(PaiType::SIDAIER_T, fieldRank(bit), 1, 1, rest.bits);
+            else if (allEven(rest)) m = Move::make(PaiType::SIDAIER_T, fieldRank(bit), 1, 2, rest.bits);
+            else continue;
+            if (m > p) return true;
+        }
+    }
+
+    // 带翅膀的飞机：机身为 len 个连续三张，其余张数正好是 len 张单牌或 len 对
+    for (int len = 2; len <= 6; len++) {
+        int wing = n == 4 * len ? 1 : (n == 5 * len ? 2 : 0);
+        if (!wing) continue;
+        for (unsigned long long x = runStarts(g3, len); x; x &= x - 1) {
+            int h = fieldRank(lowBit(x));
+            unsigned long long run = kRunTable.bits[h][len];
+            Hand rest;
+            rest.bits = a.bits - run * 3;
+            if (wing == 2 && !allEven(rest)) continue;
+            if (Move::make(PaiType::FEIJI_T, h, len, wing, rest.bits) > p) return true;
+        }
+    }
+    return false;
+}
+
+bool staticWin(Hand a, Hand b, Move p) {
+    if (a.empty()) return false;
+    if (oneMoveFinish(a, p)) return true;
+    if (!p.isPass()) return false;
+
+    // 敌方的压制能力
+    const bool rocket = (b.bits & JOKERS) == JOKERS;
+    const unsigned long long bomb = b.ge4() & NO_JOKER;
+    const unsigned long long b1 = b.ge1(), b2 = b.ge2(), b3 = b.ge3();
+
+    // 对 a 的每个自然分组判断敌方能否压过
+    int hard = 0;      ///< 能被压过且不能被带走的组 (三张、炸弹)
+    int loose = 0;     ///< 能被压过的单张与对子 (可以作为三带的带牌)
+    int carriers = 0;  ///< 压不住的三张 (每个可以带走一个单张或对子)
+
+    unsigned long long groups = a.ge1();
+    if ((a.bits & JOKERS) == JOKERS) groups &= ~JOKERS; // 双王作为王炸，任何牌都压不住
+
+    for (unsigned long long x = groups; x; x &= x - 1) {
+        int bit = lowBit(x);
+        int r = fieldRank(bit);
+        int c = a.count(r);
+        unsigned long long higher = above(r);
+        bool beaten;
+        switch (c) {
+            case 1: beaten = rocket || bomb || (b1 & higher); break;
+            case 2: beaten = rocket || bomb || (b2 & higher); break;
+            case 3: beaten = rocket || bomb || (b3 & higher); break;
+            default: beaten = rocket || (bomb & higher); break;
+        }
+        if (!beaten) {
+            if (c == 3) carriers++;
+        } else if (c <= 2) {
+            loose++;
+        } else {
+            hard++;
+        }
+    }
+    int open = hard + (loose > carriers ? loose - carriers : 0);
+    return open <= 1;
+}
+
+/**
+ * @brief 掩码 g 中位于某个长度 >= len 的连续段内的点数
+ */
+static inline unsigned long long inRuns(unsigned long long g, int len) {
+    unsigned long long start = runStarts(g, len);
+    unsigned long long covered = start;
+    for (int i = 1; i < len; i++) covered |= start << (3 * i);
+    return covered;
+}
+
+/**
+ * @brief 手牌中可能参与连牌 (顺子、连对、飞机) 的点数
+ *
+ * 张数只会减少，因此不在这里的点数今后也不会出现在任何连牌中。
+ */
+static inline unsigned long long runRanks(Hand h) {
+    return inRuns(h.ge1(), 5) | inRuns(h.ge2(), 3) | inRuns(h.ge3(), 2);
+}
+
+/// 每个非空字段最低位置 1
+static inline unsigned long long fields(unsigned long long x) {
+    return (x | (x >> 1) | (x >> 2)) & Hand::LSB;
+}
+
+bool dominatedKick(Hand a, Hand b, Move m) {
+    const unsigned long long kick = m.kick();
+    if (!kick) return false;
+    const unsigned long long kickFields = fields(kick);
+    const unsigned long long bodyFields = fields(m.body());
+    const unsigned long long bFields = b.ge1();
+    Hand h;
+    h.bits = a.bits - m.delta();
+
+    for (unsigned long long ys = kickFields & NO_JOKER; ys; ys &= ys - 1) {
+        const int ybit = lowBit(ys);
+        const int y = fieldRank(ybit);
+        const unsigned long long k = (kick >> ybit) & 7;
+        // 带走 y 之前的手牌
+        Hand r;
+        r.bits = h.bits + (k << ybit);
+        const unsigned long long runs = runRanks(r);
+        if (runs & (1ULL << ybit)) continue;
+
+        const int c = r.count(y);
+        unsigned long long xs = r.ge(c) & ~r.ge(c + 1) & ((1ULL << ybit) - 1) & ~kickFields & ~bodyFields & ~runs;
+        for (; xs; xs &= xs - 1) {
+            const int xbit = lowBit(xs);
+            // 支配：y 被全部带走；等价：对手在 [x, y] 之间没有牌
+            if ((unsigned long long)c == k) return true;
+            const unsigned long long span = ((1ULL << (ybit + 3)) - 1) & ~((1ULL << xbit) - 1);
+            if (!(bFields & span)) return true;
+        }
+    }
+    return false;
+}
+
+size_t pruneKicks(Hand a, Hand b, std::vector<Move> &moves, size_t base) {
+    size_t out = base;
+    for (size_t i = base; i < moves.size(); i++) {
+        if (dominatedKick(a, b, moves[i])) continue;
+        moves[out++] = moves[i];
+    }
+    moves.resize(out);
+    return out - base;
+}
@@ -0,0 +1,347 @@
+/**
+ * @file move.cc
+ * @brief 紧凑着法的生成、出牌/回溯与显示适配
+ *
+ * 搜索只使用 Move 值类型，Pai 类层次仅在显示时通过 toPai() 构造。
+ */
+
+#include "../include/move.h"
+#include <sstream>
+
+const int kPaiUnit[10] = {
+    1, ///< DAN_T
+    2, ///< DUIZI_T
+    1, ///< SHUNZI_T
+    2, ///< LIANDUI_T
+    4, ///< SIDAIER_T
+    3, ///< FEIJI_T
+    3, ///< SANDAI_T
+    4, ///< ZHADAN_T
+    1, ///< WANGZHA_T (head=16, length=2)
+    0, ///< PASS_T
+};
+
+/// 编译期整数序列 (C++11 没有 std::index_sequence)
+template <int... I> struct IndexSeq {};
+template <int N, int... I> struct MakeIndexSeq : MakeIndexSeq<N - 1, N - 1, I...> {};
+template <int... I> struct MakeIndexSeq<0, I...> { typedef IndexSeq<I...> type; };
+
+template <int... I>
+constexpr RunTable makeRunTable(IndexSeq<I...>) {
+    return RunTable{{runBits(I / 13, I % 13)...}};
+}
+
+const RunTable kRunTable = makeRunTable(MakeIndexSeq<MAX_N * 13>::type());
+
+static_assert(runBits(3, 5) == 0x1249ULL, "runBits: 3..7");
+static_assert(runBits(10, 5) == 0x1249ULL << 21, "runBits: 10..A");
+static_assert(runBits(16, 2) == (Hand::LSB >> 39 << 39), "runBits: jokers");
+
+void Move::take(int *arr) const {
+    int u = kPaiUnit[(int)type()];
+    for (int i = head(), I = head() + length(); i < I; i++) arr[i] -= u;
+    for (unsigned long long k = kick(); k; ) {
+        int f = lowBit(k) / 3;
+        arr[f + 3] -= (int)((k >> (f * 3)) & 7);
+        k &= ~(7ULL << (f * 3));
+    }
+}
+
+void Move::back(int *arr) const {
+    int u = kPaiUnit[(int)type()];
+    for (int i = head(), I = head() + length(); i < I; i++) arr[i] += u;
+    for (unsigned long long k = kick(); k; ) {
+        int f = lowBit(k) / 3;
+        arr[f + 3] += (int)((k >> (f * 3)) & 7);
+        k &= ~(7ULL << (f * 3));
+    }
+}
+
+/**
+ * @brief 飞机翅膀枚举 (对应 pai.cc 中的 findWingsRecursive，但直接累加带牌计数)
+ * @param rest 去掉机身后的手牌
+ */
+static void genWings(Hand rest, int startVal, int countNeeded, int wing, int h, int len,
+                     unsigned long long kick, Move pre, vector<Move> &out) {
+    if (countNeeded == 0) {
+        Move m = Move::make(PaiType::FEIJI_T, h, len, wing, kick);
+        if (m > pre) out.push_back(m);
+        return;
+    }
+    if (startVal > 17) return;
+
+    int unit = (wing == 2 ? 2 : 1);
+    int maxTake = rest.count(startVal) / unit;
+
+    for (int k = 0; k <= maxTake && k <= countNeeded; k++) {
+        genWings(rest, startVal + 1, countNeeded - k, wing, h, len,
+                 kick + Move::kickBit(startVal) * (unsigned long long)(k * unit), pre, out);
+    }
+}
+
+MoveGen::MoveGen(Hand h, Move pre) : hand(h), pre(pre), stage(PASS_S) {
+    // 上家不是 PASS 时只有同牌型 (同长度、同带法)、炸弹、王炸和 PASS 可能压过
+    const PaiType t = pre.type();
+    if (t == PaiType::PASS_T) {
+        stages = ~0u;
+        minHead = 3;
+    } else {
+        stages = (1u << PASS_S) | (1u << ROCKET_S) | (1u << BOMB_S);
+        switch (t) {
+            case PaiType::SANDAI_T:  stages |= 1u << SANDAI_S; break;
+            case PaiType::FEIJI_T:   stages |= 1u << FEIJI_S; break;
+            case PaiType::SIDAIER_T: stages |= 1u << SIDAIER_S; break;
+            case PaiType::LIANDUI_T: stages |= 1u << LIANDUI_S; break;
+            case PaiType::SHUNZI_T:  stages |= 1u << SHUNZI_S; break;
+            case PaiType::DUIZI_T:   stages |= 1u << DUIZI_S; break;
+            case PaiType::DAN_T:     stages |= 1u << DAN_S; break;
+            default: break;
+        }
+        // 王炸之后只能 PASS；炸弹之后只有更大的炸弹
+        if (t == PaiType::WANGZHA_T) stages &= (1u << PASS_S);
+        minHead = pre.head() + 1;
+    }
+}
+
+/**
+ * @brief 点数 >= r 的字段掩码 (展开形式)
+ */
+static inline unsigned long long atLeast(int r) {
+    return r <= 3 ? Hand::LSB : Hand::LSB & ~((1ULL << Hand::shift(r)) - 1);
+}
+
+bool MoveGen::next(vector<Move> &out) {
+    while (stage != DONE_S) {
+        Stage s = stage;
+        stage = (Stage)(stage + 1);
+        if (!(stages & (1u << s))) continue;
+        size_t before = out.size();
+        genStage(s, out);
+        if (out.size() > before) return true;
+    }
+    return false;
+}
+
+void MoveGen::genStage(Stage s, vector<Move> &out) const {
+    const bool lead = pre.isPass();
+    // 同牌型跟牌时主牌起点的下界、长度与带法都由上家决定
+    const unsigned long long above = atLeast(lead ? 3 : minHead);
+    Move m;
+
+    switch (s) {
+        case PASS_S:
+            m = Move::pass();
+            if (m > pre) out.push_back(m);
+            break;
+
+        case ROCKET_S:
+            if (hand.count(16) > 0 && hand.count(17) > 0) {
+                m = Move::make(PaiType::WANGZHA_T, 16, 2, 0, 0);
+                if (m > pre) out.push_back(m);
+            }
+            break;
+
+        case BOMB_S: {
+            unsigned long long x = hand.ge4();
+            if (pre.type() == PaiType::ZHADAN_T) x &= above;
+            for (; x; ) {
+                int bit = highBit(x);
+                x ^= 1ULL << bit;
+                m = Move::make(PaiType::ZHADAN_T, fieldRank(bit), 1, 0, 0);
+                if (m > pre) out.push_back(m);
+            }
+            break;
+        }
+
+        case SANDAI_S: {
+            const unsigned long long g1 = hand.ge1(), g2 = hand.ge2();
+            const int wing = pre.wing();
+            for (unsigned long long x = hand.ge3() & above; x; ) {
+                int bit = highBit(x);
+                x ^= 1ULL << bit;
+                int i = fieldRank(bit);
+                if (lead || wing == 0) {
+                    m = Move::make(PaiType::SANDAI_T, i, 1, 0, 0);
+                    if (m > pre) out.push_back(m);
+                }
+                if (!lead && wing == 0) continue;
+                for (unsigned long long y = g1 & ~(1ULL << bit); y; y &= y - 1) {
+                    int kb = lowBit(y);
+                    unsigned long long k = 1ULL << kb;
+                    if (lead || wing == 1) {
+                        m = Move::make(PaiType::SANDAI_T, i, 1, 1, k);
+                        if (m > pre) out.push_back(m);
+                    }
+                    if ((lead || wing == 2) && (g2 & k)) {
+                        m = Move::make(PaiType::SANDAI_T, i, 1, 2, k * 2);
+                        if (m > pre) out.push_back(m);
+                    }
+                }
+            }
+            break;
+        }
+
+        case FEIJI_S: {
+            // 机身：长度 len 的连续三张，所有起点一次求出 (逐级与上更远的一个点数)
+            const unsigned long long g3 = hand.ge3() & RUN_RANKS;
+            int lo = lead ? 2 : pre.length(), hi = lead ? 6 : pre.length();
+            unsigned long long starts = g3;
+            for (int len = 2; len <= hi; len++) {
+                starts &= g3 >> (3 * (len - 1));
+                if (!starts) break;
+                if (len < lo) continue;
+                for (unsigned long long x = starts & above; x; ) {
+                    int bit = highBit(x);
+                    x ^= 1ULL << bit;
+                    int h = fieldRank(bit);
+                    Hand rest;
+                    rest.bits = hand.bits - kRunTable.bits[h][len] * 3;
+                    if (lead || pre.wing() == 0) {
+                        m = Move::make(PaiType::FEIJI_T, h, len, 0, 0);
+                        if (m > pre) out.push_back(m);
+                    }
+                    if (lead || pre.wing() == 1) genWings(rest, 3, len, 1, h, len, 0, pre, out);
+                    if (lead || pre.wing() == 2) genWings(rest, 3, len, 2, h, len, 0, pre, out);
+                }
+            }
+            break;
+        }
+
+        case SIDAIER_S: {
+            const unsigned long long noJoker = (1ULL << Hand::shift(16)) - 1;
+            for (unsigned long long x = hand.ge4() & noJoker & above; x; ) {
+                int bit = highBit(x);
+                x ^= 1ULL << bit;
+                int i = fieldRank(bit);
+                Hand rest;
+                rest.bits = hand.bits - (4ULL << bit);
+                const unsigned long long r1 = rest.ge1() & noJoker, r2 = rest.ge2() & noJoker, r4 = rest.ge4() & noJoker;
+                // 带两张单牌 (不能带王)
+                if (lead || pre.wing() == 1) {
+                    for (unsigned long long y = r1; y; y &= y - 1) {
+                        unsigned long long j = y & (0 - y);
+                        if (r2 & j) {
+                            m = Move::make(PaiType::SIDAIER_T, i, 1, 1, j * 2);
+                            if (m > pre) out.push_back(m);
+                        }
+                        for (unsigned long long z = y & (y - 1); z; z &= z - 1) {
+                            unsigned long long k = z & (0 - z);
+                            m = Move::make(PaiType::SIDAIER_T, i, 1, 1, j + k);
+                            if (m > pre) out.push_back(m);
+                        }
+                    }
+                }
+                // 带两对 (不能带王)
+                if (lead || pre.wing() == 2) {
+                    for (unsigned long long y = r2; y; y &= y - 1) {
+                        unsigned long long j = y & (0 - y);
+                        if (r4 & j) {
+                            m = Move::make(PaiType::SIDAIER_T, i, 1, 2, j * 4);
+                            if (m > pre) out.push_back(m);
+                        }
+                        for (unsigned long long z = y & (y - 1); z; z &= z - 1) {
+                            unsigned long long k = z & (0 - z);
+                            m = Move::make(PaiType::SIDAIER_T, i, 1, 2, (j + k) * 2);
+                            if (m > pre) out.push_back(m);
+                        }
+                    }
+                }
+            }
+            break;
+        }
+
+        case LIANDUI_S:
+        case SHUNZI_S: {
+            const bool pairs = s == LIANDUI_S;
+            const unsigned long long g = (pairs ? hand.ge2() : hand.ge1()) & RUN_RANKS;
+            const PaiType t = pairs ? PaiType::LIANDUI_T : PaiType::SHUNZI_T;
+            int lo = lead ? (pairs ? 3 : 5) : pre.length(), hi = lead ? 12 : pre.length();
+            unsigned long long starts = g;
+            for (int l = 2; l <= hi; l++) {
+                starts &= g >> (3 * (l - 1));
+                if (!starts) break;
+                if (l < lo) continue;
+                for (unsigned long long x = starts & above; x; ) {
+                    int bit = highBit(x);
+                    x ^= 1ULL << bit;
+                    m = Move::make(t, fieldRank(bit), l, 0, 0);
+                    if (m > pre) out.push_back(m);
+                }
+            }
+            break;
+        }
+
+        case DUIZI_S:
+        case DAN_S: {
+            const bool pairs = s == DUIZI_S;
+            const PaiType t = pairs ? PaiType::DUIZI_T : PaiType::DAN_T;
+            for (unsigned long long x = (pairs ? hand.ge2() : hand.ge1()) & above; x; ) {
+                int bit = highBit(x);
+                x ^= 1ULL << bit;
+                m = Move::make(t, fieldRank(bit), 1, 0, 0);
+                if (m > pre) out.push_back(m);
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void genLegalMoves(Hand hand, Move pre, vector<Move> &out) {
+    MoveGen gen(hand, pre);
+    while (gen.next(out)) {}
+}
+
+Pai *toPai(Move m) {
+    switch (m.type()) {
+        case PaiType::DAN_T:     return new DAN(m.head());
+        case PaiType::DUIZI_T:   return new DUIZI(m.head());
+        case PaiType::SHUNZI_T:  return new SHUNZI(m.head(), m.length());
+        case PaiType::LIANDUI_T: return new LIANDUI(m.head(), m.length());
+        case PaiType::ZHADAN_T:  return new ZHADAN(m.head());
+        case PaiType::WANGZHA_T: return new WANGZHA();
+        case PaiType::SANDAI_T: {
+            Pai *dai;
+            if (m.wing() == 0) dai = new PASS();
+            else if (m.wing() == 1) dai = new DAN(m.kickLow());
+            else dai = new DUIZI(m.kickLow());
+            return new SANDAI(m.head(), dai);
+        }
+        case PaiType::SIDAIER_T:
+            return new SIDAIER(m.head(), m.kickLow(), m.kickHigh(), m.wing() == 2);
+        case PaiType::FEIJI_T: {
+            vector<int> wings;
+            int unit = (m.wing() == 2 ? 2 : 1);
+            for (int r = 3; r < MAX_N; r++) {
+                int c = (int)((m.kick() >> ((r - 3) * 3)) & 7);
+                for (int k = 0; k < c / unit; k++) wings.push_back(r);
+            }
+            return new FEIJI(m.head(), m.length(), m.wing(), wings);
+        }
+        default: return new PASS();
+    }
+}
+
+string describePai(Pai *p) {
+    stringstream ss;
+    streambuf *old_buf = cout.rdbuf(ss.rdbuf());
+    p->output();
+    cout.rdbuf(old_buf);
+    return ss.str();
+}
+
+string describeMove(Move m) {
+    Pai *p = toPai(m);
+    string s = describePai(p);
+    delete p;
+    return s;
+}
+
+const char *typeName(PaiType t) {
+    static const char *const NAMES[] = {
+        "DAN", "DUIZI", "SHUNZI", "LIANDUI", "SIDAIER", "FEIJI", "SANDAI", "ZHADAN", "WANGZHA", "PASS",
+    };
+    return NAMES[(int)t];
+}
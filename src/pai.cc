@@ -357,14 +357,16 @@ void LIANDUI::back(int *arr) {
 FEIJI::FEIJI(int head, int length, int wingType, const vector<int>& wings) 
     : Pai(PaiType::FEIJI_T), head(head), length(length), wingType(wingType), wings(wings) {}
 
-// Move DFS struct outside of function or make it a helper function
-// Since local classes cannot have static member functions in C++11 (it's allowed but scope is tricky)
-// Let's just make a recursive helper function outside.
-
+/**
+ * @brief 枚举飞机翅膀
+ *
+ * 按点数递增依次决定每种点数取几个单位，凑满 countNeeded 个单位时直接构造 FEIJI
+ * 追加到 out；current 作为回溯栈复用，不再先收集所有组合。
+ */
 static void findWingsRecursive(int startVal, int countNeeded, int type, int *arr, int h, int len, 
-                vector<int>& current, vector<vector<int>>& out) {
+                vector<int>& current, vector<Pai *>& out) {
     if (countNeeded == 0) {
-        out.push_back(current);
+        out.push_back(new FEIJI(h, len, type, current));
         return;
     }
     if (startVal > 17) return;
@@ -393,6 +395,7 @@ static void findWingsRecursive(int startVal, int countNeeded, int type, int *arr
 
 vector<Pai *> FEIJI::get(int *arr) {
     vector<Pai *> ret;
+    vector<int> current;
     
     // Body length: at least 2
     // Max length: 12 (3 to A is 12 cards)
@@ -412,22 +415,10 @@ vector<Pai *> FEIJI::get(int *arr) {
             ret.push_back(new FEIJI(h, len, 0, {}));
             
             // 2. Wings: Singles (type 1)
-            vector<vector<int>> wingsList;
-            vector<int> current;
-            findWingsRecursive(3, len, 1, arr, h, len, current, wingsList);
-            
-            for (auto& w : wingsList) {
-                ret.push_back(new FEIJI(h, len, 1, w));
-            }
+            findWingsRecursive(3, len, 1, arr, h, len, current, ret);
             
             // 3. Wings: Pairs (type 2)
-            vector<vector<int>> wingsListDui;
-            vector<int> currentDui;
-            findWingsRecursive(3, len, 2, arr, h, len, currentDui, wingsListDui);
-            
-            for (auto& w : wingsListDui) {
-                ret.push_back(new FEIJI(h, len, 2, w));
-            }
+            findWingsRecursive(3, len, 2, arr, h, len, current, ret);
         }
     }
     return ret;
@@ -0,0 +1,239 @@
+/**
+ * @file perft.cc
+ * @brief 着法生成器的 perft 计数、吞吐量测试与逐节点比较
+ */
+
+#include "../include/perft.h"
+#include "../include/move.h"
+#include "../include/json.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// 牌型数 (PaiType 的取值个数)
+static const int TYPES = (int)PaiType::PASS_T + 1;
+
+/// 每个局面每个深度最多输出的不一致节点数
+static const int MAX_REPORTS = 5;
+
+/**
+ * @brief 一次 perft 的计数
+ */
+struct PerftCount {
+    unsigned long long nodes = 0;     ///< 恰好 depth 手的序列数
+    unsigned long long ends = 0;      ///< 提前出完而结束的序列数
+    unsigned long long generated = 0; ///< 所有节点生成的着法总数
+    unsigned long long moves[TYPES] = {}; ///< 最后一手的牌型分布
+    double ms = 0;
+
+    bool operator==(const PerftCount &o) const {
+        return nodes == o.nodes && ends == o.ends && generated == o.generated
+               && std::equal(moves, moves + TYPES, o.moves);
+    }
+};
+
+static bool emptyHand(const int *arr) {
+    for (int i = 3; i < MAX_N; i++) {
+        if (arr[i]) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief MoveGen 的 perft (着法追加到共享的着法栈，与搜索相同)
+ * @param a 出牌方手牌
+ * @param b 另一方手牌
+ * @param last 需要压过的牌
+ */
+static void fastPerft(Hand a, Hand b, Move last, int depth, PerftCount &c, vector<Move> &stack) {
+    size_t base = stack.size();
+    genLegalMoves(a, last, stack);
+    size_t n = stack.size() - base;
+    c.generated += n;
+    for (size_t k = base; k < base + n; k++) {
+        Move m = stack[k];
+        if (depth == 1) {
+            c.nodes++;
+            c.moves[(int)m.type()]++;
+            continue;
+        }
+        Hand next = a;
+        m.take(next);
+        if (next.empty()) c.ends++;
+        else fastPerft(b, next, m, depth - 1, c, stack);
+    }
+    stack.resize(base);
+}
+
+/**
+ * @brief Pai::getLegalPai 的 perft (参考实现)
+ * @param a 出牌方手牌数组 (出牌、回溯后恢复原状)
+ * @param b 另一方手牌数组
+ * @param last 需要压过的牌
+ */
+static void refPerft(int *a, int *b, Pai *last, int depth, PerftCount &c) {
+    vector<Pai *> moves = Pai::getLegalPai(a, last);
+    c.generated += moves.size();
+    for (Pai *p : moves) {
+        if (depth == 1) {
+            c.nodes++;
+            c.moves[(int)p->type]++;
+            continue;
+        }
+        p->take(a);
+        if (emptyHand(a)) c.ends++;
+        else refPerft(b, a, p, depth - 1, c);
+        p->back(a);
+    }
+    for (Pai *p : moves) delete p;
+}
+
+static string jsonStrings(const vector<string> &v) {
+    string s = "[";
+    for (size_t i = 0; i < v.size(); i++) {
+        if (i) s += ", ";
+        s += "\"" + json_escape(v[i]) + "\"";
+    }
+    return s + "]";
+}
+
+/**
+ * @brief 逐个节点比较两个生成器的着法集合 (按文字描述，计重复)
+ *
+ * 两者都有的着法继续向下比较；不一致的节点输出一行 mismatch。
+ *
+ * @param prefix 输出行的开头 ({"id": .., "depth": ..)
+ * @param path 从根到当前节点的着法
+ * @param reports 已输出的不一致节点数 (达到 MAX_REPORTS 后停止)
+ */
+static void verify(int *a, int *b, Pai *lastPai, Move last, int depth, const string &prefix,
+                   vector<string> &path, int &reports) {
+    vector<Pai *> refs = Pai::getLegalPai(a, lastPai);
+    vector<Move> fast;
+    genLegalMoves(Hand::fromArray(a), last, fast);
+
+    std::map<string, int> count; ///< 参考实现的次数减去 MoveGen 的次数
+    std::map<string, Pai *> refOf;
+    std::map<string, Move> fastOf;
+    for (Pai *p : refs) {
+        string d = describePai(p);
+        count[d]++;
+        refOf[d] = p;
+    }
+    for (Move m : fast) {
+        string d = describeMove(m);
+        count[d]--;
+        fastOf[d] = m;
+    }
+    vector<string> missing, extra;
+    for (auto &kv : count) {
+        for (int k = 0; k < kv.second; k++) missing.push_back(kv.first);
+        for (int k = 0; k < -kv.second; k++) extra.push_back(kv.first);
+    }
+    if (!missing.empty() || !extra.empty()) {
+        reports++;
+        string line = prefix + ", \"mismatch\": {\"path\": " + jsonStrings(path);
+        line += ", \"hand\": " + json_hand(Hand::fromArray(a)) + ", \"other\": " + json_hand(Hand::fromArray(b));
+        line += ", \"last\": \"" + json_escape(describePai(lastPai)) + "\"";
+        line += ", \"missing\": " + jsonStrings(missing) + ", \"extra\": " + jsonStrings(extra) + "}}";
+        puts(line.c_str());
+    }
+
+    for (auto &kv : refOf) {
+        if (depth == 1 || reports >= MAX_REPORTS) break;
+        auto it = fastOf.find(kv.first);
+        if (it == fastOf.end()) continue;
+        Pai *p = kv.second;
+        p->take(a);
+        if (!emptyHand(a)) {
+            path.push_back(kv.first);
+            verify(b, a, p, it->second, depth - 1, prefix, path, reports);
+            path.pop_back();
+        }
+        p->back(a);
+    }
+    for (Pai *p : refs) delete p;
+}
+
+static string countJson(const PerftCount &c) {
+    char buf[96];
+    snprintf(buf, sizeof(buf), "{\"ms\": %.3f, \"moves_per_sec\": %.0f}", c.ms,
+             c.ms > 0 ? c.generated / c.ms * 1000 : 0.0);
+    return buf;
+}
+
+/**
+ * @brief 对一个局面按给定深度运行 perft 并输出结果
+ * @return 两个生成器结果一致时返回 true
+ */
+static bool perftPosition(int id, int *a, int *b, int depth, PerftGen gen) {
+    PerftCount fast, ref;
+    if (gen != PerftGen::REF) {
+        vector<Move> stack;
+        auto start = std::chrono::steady_clock::now();
+        fastPerft(Hand::fromArray(a), Hand::fromArray(b), Move::pass(), depth, fast, stack);
+        fast.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    if (gen != PerftGen::FAST) {
+        PASS lead;
+        auto start = std::chrono::steady_clock::now();
+        refPerft(a, b, &lead, depth, ref);
+        ref.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    const PerftCount &c = gen == PerftGen::REF ? ref : fast;
+    string prefix = "{\"id\": " + to_string(id) + ", \"depth\": " + to_string(depth);
+    string line = prefix + ", \"nodes\": " + to_string(c.nodes) + ", \"ends\": " + to_string(c.ends)
+                  + ", \"generated\": " + to_string(c.generated) + ", \"moves\": {";
+    bool first = true;
+    for (int t = 0; t < TYPES; t++) {
+        if (!c.moves[t]) continue;
+        line += string(first ? "" : ", ") + "\"" + typeName((PaiType)t) + "\": " + to_string(c.moves[t]);
+        first = false;
+    }
+    line += "}";
+    if (gen != PerftGen::REF) line += ", \"fast\": " + countJson(fast);
+    if (gen != PerftGen::FAST) line += ", \"ref\": " + countJson(ref);
+    bool match = gen != PerftGen::BOTH || fast == ref;
+    if (gen == PerftGen::BOTH) line += string(", \"match\": ") + (match ? "true" : "false");
+    puts((line + "}").c_str());
+
+    if (!match) {
+        PASS lead;
+        vector<string> path;
+        int reports = 0;
+        verify(a, b, &lead, Move::pass(), depth, prefix, path, reports);
+    }
+    fflush(stdout);
+    return match;
+}
+
+int runPerft(FILE *in, int maxDepth, PerftGen gen) {
+    // # 开头的行为注释
+    string text;
+    char buf[1024];
+    while (fgets(buf, sizeof(buf), in)) {
+        const char *p = buf;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p != '#') text += buf;
+    }
+    istringstream ss(text);
+
+    bool allMatch = true;
+    for (int id = 0; !(ss >> std::ws).eof(); id++) {
+        int a[MAX_N + 5] = {0}, b[MAX_N + 5] = {0};
+        string error;
+        if (!parseHand(ss, a, error) || !parseHand(ss, b, error)) {
+            fprintf(stderr, "position %d: %s\n", id, error.c_str());
+            return 1;
+        }
+        if (emptyHand(a) || emptyHand(b)) continue;
+        for (int d = 1; d <= maxDepth; d++) {
+            if (!perftPosition(id, a, b, d, gen)) allMatch = false;
+        }
+    }
+    return allMatch ? 0 : 2;
+}
@@ -0,0 +1,167 @@
+/**
+ * @file plays.cc
+ * @brief 最少出牌次数的动态规划与出牌竞速判定
+ */
+
+#include "../include/plays.h"
+#include "../include/eval.h"
+#include "../include/tt.h"
+#include <atomic>
+
+/**
+ * @brief 最少手数缓存
+ *
+ * 直接映射、无锁：每个表项两个字，check = 校验字 ^ data，data 为最优拆法的第一手。
+ * 校验字：bits 0-44 手牌，bits 45-49 最少手数，bit 50 有效位。
+ * 并发写入撕裂的表项校验失败，按未命中处理。
+ */
+struct PlaysEntry {
+    std::atomic<unsigned long long> check;
+    std::atomic<unsigned long long> data;
+};
+
+static const int PLAYS_CACHE_BITS = 20;
+static const unsigned long long HAND_MASK = (1ULL << 45) - 1;
+static const int VALUE_SHIFT = 45;
+static const int USED_BIT = 50;
+
+static PlaysEntry playsCache[1 << PLAYS_CACHE_BITS];
+
+static inline PlaysEntry &slot(Hand h) {
+    return playsCache[(h.bits * 0x9E3779B97F4A7C15ULL) >> (64 - PLAYS_CACHE_BITS)];
+}
+
+/**
+ * @brief 计算最少手数及最优的第一手 (带缓存)
+ */
+static int solvePlays(Hand h, Move &first) {
+    if (h.empty()) {
+        first = Move::pass();
+        return 0;
+    }
+    PlaysEntry &e = slot(h);
+    unsigned long long d = e.data.load(std::memory_order_relaxed);
+    unsigned long long c = e.check.load(std::memory_order_relaxed) ^ d;
+    if ((c & HAND_MASK) == h.bits && ((c >> USED_BIT) & 1)) {
+        first.bits = d;
+        return (int)((c >> VALUE_SHIFT) & 31);
+    }
+
+    int best = 64;
+    // 枚举覆盖最小点数的着法
+    const unsigned long long low = 7ULL << lowBit(h.bits) / 3 * 3;
+    std::vector<Move> moves;
+    genLegalMoves(h, Move::pass(), moves);
+    for (Move m : moves) {
+        if (!(m.delta() & low)) continue;
+        Hand rest;
+        rest.bits = h.bits - m.delta();
+        if (rest.empty()) {
+            best = 1;
+            first = m;
+            break;
+        }
+        if (best <= 2) continue;
+        Move sub;
+        int v = 1 + solvePlays(rest, sub);
+        if (v < best) {
+            best = v;
+            first = m;
+        }
+    }
+
+    e.check.store((h.bits | ((unsigned long long)best << VALUE_SHIFT) | (1ULL << USED_BIT)) ^ first.bits,
+                  std::memory_order_relaxed);
+    e.data.store(first.bits, std::memory_order_relaxed);
+    return best;
+}
+
+int minPlays(Hand h) {
+    Move first;
+    return solvePlays(h, first);
+}
+
+void minPlan(Hand h, std::vector<Move> &plan) {
+    plan.clear();
+    while (!h.empty()) {
+        Move first;
+        solvePlays(h, first);
+        plan.push_back(first);
+        first.take(h);
+    }
+}
+
+/// 点数严格大于 r 的字段掩码 (展开形式)
+static inline unsigned long long above(int r) {
+    return Hand::LSB & ~((1ULL << (Hand::shift(r) + 3)) - 1);
+}
+
+bool canBeat(Hand b, Move g) {
+    PaiType t = g.type();
+    if (t == PaiType::PASS_T) return !b.empty();
+    if (t == PaiType::WANGZHA_T) return false;
+    if (b.count(16) && b.count(17)) return true;
+    unsigned long long bombs = b.ge4() & ((1ULL << Hand::shift(16)) - 1);
+    if (t == PaiType::ZHADAN_T) return (bombs & above(g.head())) != 0;
+    if (bombs) return true;
+
+    int unit = kPaiUnit[(int)t];
+    unsigned long long have = b.ge(unit);
+    switch (t) {
+        case PaiType::DAN_T:
+        case PaiType::DUIZI_T:
+        case PaiType::SANDAI_T:
+            return (have & above(g.head())) != 0;
+        case PaiType::SIDAIER_T:
+            // 需要一个四张，而四张本身就是炸弹
+            return false;
+        default: {
+            // 顺子、连对、飞机：同长度、更大的起点
+            return (runStarts(have, g.length()) & above(g.head())) != 0;
+        }
+    }
+}
+
+unsigned int responseCode(Hand a, Move p) {
+    if (p.isPass()) return 0;
+    if (!canBeat(a, p)) return (unsigned int)PaiType::WANGZHA_T;
+
+    PaiType t = p.type();
+    unsigned long long heads;
+    if (t == PaiType::ZHADAN_T) {
+        heads = a.ge4() & ((1ULL << Hand::shift(16)) - 1);
+    } else if (t == PaiType::SHUNZI_T || t == PaiType::LIANDUI_T || t == PaiType::FEIJI_T) {
+        heads = runStarts(a.ge(kPaiUnit[(int)t]), p.length());
+    } else {
+        heads = a.ge(kPaiUnit[(int)t]);
+    }
+    // 能作为起点且压不过 p 的点数个数 (bits 10-13)，其上的起点都能压过
+    return p.shape() | ((unsigned int)popCount(heads & ~above(p.head())) << 10);
+}
+
+bool raceWin(Hand a, Hand b) {
+    // 沿缓存中记录的第一手逐步展开拆法 (与 minPlan 相同，但不分配内存)
+    int open = 0;
+    while (!a.empty()) {
+        Move first;
+        solvePlays(a, first);
+        if (canBeat(b, first) && ++open > 1) return false;
+        first.take(a);
+    }
+    return true;
+}
+
+bool raceLoss(Hand a, Hand b, Move p) {
+    const unsigned long long jokers = (1ULL << Hand::shift(16)) | (1ULL << Hand::shift(17));
+    Move finish;
+    if (b.bits == jokers) {
+        finish = Move::make(PaiType::WANGZHA_T, 16, 2, 0, 0);
+    } else {
+        unsigned long long g4 = b.ge4();
+        if (!g4 || b.bits != (4ULL << lowBit(g4))) return false;
+        finish = Move::make(PaiType::ZHADAN_T, fieldRank(lowBit(g4)), 1, 0, 0);
+        if (a.count(16) && a.count(17)) return false;
+        if (a.ge4() & above(finish.head())) return false;
+    }
+    return !oneMoveFinish(a, p);
+}
@@ -0,0 +1,221 @@
+/**
+ * @file pn.cc
+ * @brief df-pn 证明数搜索
+ */
+
+#include "../include/pn.h"
+#include "../include/search.h"
+#include "../include/plays.h"
+#include "../include/eval.h"
+#include <cstdlib>
+
+/// 证明数 / 反证数的无穷大 (已证明)
+static const unsigned int PN_INF = 1u << 30;
+
+/// 表项有效位 (存放在 Entry::a 的最高位)
+static const unsigned long long PN_USED = 1ULL << 63;
+
+/// 饱和加法：有限值之和不会达到 PN_INF
+static inline unsigned int addPn(unsigned int x, unsigned int y) {
+    if (x >= PN_INF || y >= PN_INF) return PN_INF;
+    unsigned long long s = (unsigned long long)x + y;
+    return s >= PN_INF ? PN_INF - 1 : (unsigned int)s;
+}
+
+PnSearcher::PnSearcher(const std::atomic<bool> *stop, TransTable *table, size_t mb)
+    : table(table ? table : &sharedTable()), tb(tablebase().ready() ? &tablebase() : nullptr),
+      stop(stop), control(nullptr), charged(0), stopped(false), nodeCount(0), probeCount(0), hitCount(0),
+      entries(nullptr), entryMask(0) {
+    size_t n = 2;
+    while (n * 2 * sizeof(Entry) <= (mb << 20)) n *= 2;
+    // calloc 的清零页按需提供，未触及的部分不占用物理内存
+    entries = (Entry *)calloc(n, sizeof(Entry));
+    if (entries) entryMask = n - 1;
+    statsMark[0] = statsMark[1] = statsMark[2] = 0;
+}
+
+PnSearcher::~PnSearcher() {
+    flushStats();
+    free(entries);
+}
+
+bool PnSearcher::interrupted() {
+    if (stop && stop->load(std::memory_order_relaxed)) return true;
+    if (!control) return false;
+    if (nodeCount - charged >= SearchControl::POLL_NODES) {
+        unsigned long long n = nodeCount - charged;
+        charged = nodeCount;
+        return control->charge(n);
+    }
+    return control->stopped();
+}
+
+void PnSearcher::flushNodes() {
+    if (control && nodeCount > charged) control->charge(nodeCount - charged);
+    charged = nodeCount;
+    flushStats();
+}
+
+void PnSearcher::flushStats() {
+    if (statsEnabled()) {
+        SearchStats s;
+        s.nodes = nodeCount - statsMark[0];
+        s.probes = probeCount - statsMark[1];
+        s.hits = hitCount - statsMark[2];
+        addStats(s);
+        if (control) control->addStats(s);
+    }
+    statsMark[0] = nodeCount;
+    statsMark[1] = probeCount;
+    statsMark[2] = hitCount;
+}
+
+bool PnSearcher::lookup(const PositionKey &key, unsigned int &pn, unsigned int &dn) const {
+    if (!entries) return false;
+    // 两路组相联：key 所在的相邻两个表项
+    size_t i = key.hash & entryMask & ~(size_t)1;
+    for (size_t j = i; j < i + 2; j++) {
+        const Entry &e = entries[j];
+        if (e.a == (key.a.bits | PN_USED) && e.b == key.b.bits && e.code == key.code) {
+            pn = e.pn;
+            dn = e.dn;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PnSearcher::save(const PositionKey &key, unsigned int pn, unsigned int dn, unsigned int work) {
+    if (!entries) return;
+    size_t i = key.hash & entryMask & ~(size_t)1;
+    size_t victim = i;
+    for (size_t j = i; j < i + 2; j++) {
+        const Entry &e = entries[j];
+        if (!(e.a & PN_USED) || (e.a == (key.a.bits | PN_USED) && e.b == key.b.bits && e.code == key.code)) {
+            victim = j;
+            break;
+        }
+        // 淘汰展开次数较少的表项
+        if (e.work < entries[victim].work) victim = j;
+    }
+    Entry &e = entries[victim];
+    e.a = key.a.bits | PN_USED;
+    e.b = key.b.bits;
+    e.code = key.code;
+    e.pn = pn;
+    e.dn = dn;
+    e.work = work;
+}
+
+void PnSearcher::childValue(Hand a, Hand b, Move p, unsigned int &pn, unsigned int &dn) {
+    // 上家 (b) 已经出完
+    if (b.empty()) {
+        pn = PN_INF;
+        dn = 0;
+        return;
+    }
+    PositionKey key(a, b, p);
+    if (lookup(key, pn, dn)) return;
+
+    bool win;
+    probeCount++;
+    bool hit = table->probe(key, win);
+    if (hit) hitCount++;
+    if (hit || provenResult(a, b, p, tb, win)) {
+        pn = win ? 0 : PN_INF;
+        dn = win ? PN_INF : 0;
+        save(key, pn, dn, 0);
+        return;
+    }
+    pn = 1;
+    dn = 1;
+}
+
+void PnSearcher::mid(Hand a, Hand b, Move p, unsigned int thpn, unsigned int thdn, unsigned int &pn, unsigned int &dn) {
+    unsigned long long startNodes = nodeCount++;
+    if (interrupted()) {
+        stopped = true;
+        return;
+    }
+
+    PositionKey key(a, b, p);
+
+    size_t base = moveStack.size();
+    genLegalMoves(a, p, moveStack);
+    size_t n = pruneKicks(a, b, moveStack, base);
+
+    // 子局面的 pn / dn 只在展开本节点时取一次，之后只更新被展开的子局面
+    pnStack.resize(base + n);
+    dnStack.resize(base + n);
+    int plays = minPlays(a);
+    for (size_t k = 0; k < n; k++) {
+        Move m = moveStack[base + k];
+        Hand next = a;
+        m.take(next);
+        childValue(b, next, m, pnStack[base + k], dnStack[base + k]);
+        // 未展开的子局面：不增加最少手数的着法更可能是好棋，初始反证数 (子 dn) 较小
+        if (pnStack[base + k] == 1 && dnStack[base + k] == 1 && (m.isPass() || minPlays(next) >= plays)) {
+            dnStack[base + k] = 2;
+        }
+    }
+
+    for (;;) {
+        // 汇总子局面：pn = min(子 dn)，dn = sum(子 pn)
+        pn = PN_INF;
+        dn = 0;
+        unsigned int second = PN_INF; // 次小的子 dn
+        size_t best = 0;
+        for (size_t k = 0; k < n; k++) {
+            unsigned int cpn = pnStack[base + k], cdn = dnStack[base + k];
+            if (cdn < pn) {
+                second = pn;
+                pn = cdn;
+                best = k;
+            } else if (cdn < second) {
+                second = cdn;
+            }
+            dn = addPn(dn, cpn);
+            if (pn == 0) break;
+        }
+        if (pn == 0) dn = PN_INF;
+        if (pn >= thpn || dn >= thdn) break;
+
+        // 展开最有希望的子局面：子 dn 对应本节点的 pn，子 pn 对应本节点的 dn
+        unsigned long long cthpn = (unsigned long long)thdn - dn + pnStack[base + best];
+        unsigned long long cthdn = (unsigned long long)second + second / 4 + 1; // 1+ε 技巧，减少来回切换
+        if (cthdn > thpn) cthdn = thpn;
+        if (cthpn > PN_INF) cthpn = PN_INF;
+
+        Move m = moveStack[base + best];
+        Hand next = a;
+        m.take(next);
+        unsigned int cpn, cdn;
+        mid(b, next, m, (unsigned int)cthpn, (unsigned int)cthdn, cpn, cdn);
+        if (stopped) break;
+        pnStack[base + best] = cpn;
+        dnStack[base + best] = cdn;
+    }
+    moveStack.resize(base);
+    if (stopped) return;
+
+    unsigned long long work = nodeCount - startNodes;
+    save(key, pn, dn, work > 0xFFFFFFFFULL ? 0xFFFFFFFFu : (unsigned int)work);
+    if (pn == 0 || dn == 0) table->store(key, pn == 0, work);
+}
+
+bool PnSearcher::solve(Hand a, Hand b, Move p) {
+    stopped = false;
+    if (b.empty()) return false;
+    bool win;
+    if (provenResult(a, b, p, tb, win)) return win;
+
+    probeCount++;
+    if (table->probe(PositionKey(a, b, p), win)) {
+        hitCount++;
+        return win;
+    }
+
+    unsigned int pn, dn;
+    mid(a, b, p, PN_INF, PN_INF, pn, dn);
+    return pn == 0;
+}
@@ -0,0 +1,252 @@
+/**
+ * @file score.cc
+ * @brief 分值搜索：带边界类型的 alpha-beta 与 MTD(f) 零窗口逼近
+ */
+
+#include "../include/score.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+static ScoreTable st;
+static bool enabled = false;
+
+ScoreTable &scoreTable() {
+    return st;
+}
+
+void enableScore(bool on) {
+    enabled = on;
+}
+
+bool scoreEnabled() {
+    return enabled;
+}
+
+/**
+ * @brief 手牌中可能打出的炸弹与王炸数 (上界)
+ */
+static int bombCount(Hand h) {
+    return popCount(h.ge(4)) + (h.count(16) && h.count(17));
+}
+
+/**
+ * @brief 由最少出牌手数给出分值的上下界 (不需要知道胜负)
+ *
+ * a 出完至少要 minPlays(a) 次出牌，轮到 a 的是第 1, 3, 5... 手；b 同理在第 2, 4, 6... 手。
+ * 炸弹数不超过双方手中的炸弹与王炸之和。
+ */
+static void playBounds(Hand a, Hand b, int &lo, int &hi) {
+    int bombs = bombCount(a) + bombCount(b);
+    lo = -(SCORE_WIN - 2 * minPlays(b) * SCORE_PLY + bombs);
+    hi = SCORE_WIN - (2 * minPlays(a) - 1) * SCORE_PLY + bombs;
+}
+
+/**
+ * @brief 已知胜负时收紧上下界
+ *
+ * 每一手不是出牌就是 PASS，而 PASS 之后对方必须出牌，所以总手数不超过两倍的总张数。
+ */
+static void signBounds(Hand a, Hand b, bool win, int &lo, int &hi) {
+    int slowest = SCORE_WIN - 2 * (a.size() + b.size()) * SCORE_PLY;
+    if (win) lo = std::max(lo, slowest);
+    else hi = std::min(hi, -slowest);
+}
+
+/**
+ * @brief 子局面的分值 c (对手视角) 经过一手 (炸弹数 bomb) 之后的绝对值变化
+ *
+ * 当前玩家的分值为 -shift(c)：手数加一、炸弹数加 bomb。shift 单调递增，
+ * unshift 是它的逆，用于把窗口换算到子局面 (0 与 ±SCORE_INF 保持不变的符号)。
+ */
+static inline int shift(int c, int bomb) {
+    return c > 0 ? c - SCORE_PLY + bomb : c + SCORE_PLY - bomb;
+}
+
+static inline int unshift(int x, int bomb) {
+    if (x > 0) return x + SCORE_PLY - bomb;
+    if (x < 0) return x - SCORE_PLY + bomb;
+    return 0;
+}
+
+ScoreSearcher::ScoreSearcher(ScoreTable *table)
+    : table(table ? table : &st), control(nullptr), stopped(false), nodeCount(0), charged(0) {}
+
+bool ScoreSearcher::interrupted() {
+    if (!control) return false;
+    if (nodeCount - charged >= SearchControl::POLL_NODES) {
+        unsigned long long n = nodeCount - charged;
+        charged = nodeCount;
+        return control->charge(n);
+    }
+    return control->stopped();
+}
+
+void ScoreSearcher::flushNodes() {
+    if (control && nodeCount > charged) control->charge(nodeCount - charged);
+    charged = nodeCount;
+    signs.flushNodes();
+}
+
+int ScoreSearcher::search(Hand a, Hand b, Move p, int alpha, int beta) {
+    // 对手刚出完：当前玩家在第 0 手落败
+    if (b.empty()) return -SCORE_WIN;
+
+    if (interrupted()) {
+        stopped = true;
+        return 0;
+    }
+
+    // 1. 最少手数给出的上下界 (手数距离剪枝)：已有更快的胜法时，出完所需手数更多的着法不必再判定胜负
+    int lo, hi;
+    playBounds(a, b, lo, hi);
+    if (lo >= beta) return lo;
+    if (hi <= alpha) return hi;
+
+    // 2. 查表：精确值直接返回，上下界收紧区间
+    PositionKey key(a, b, p);
+    int cached;
+    Bound bound;
+    if (table->probe(key, cached, bound)) {
+        if (bound == Bound::EXACT) return cached;
+        if (bound == Bound::LOWER) lo = std::max(lo, cached);
+        else hi = std::min(hi, cached);
+        if (lo >= beta || lo == hi) return lo;
+        if (hi <= alpha) return hi;
+    }
+
+    // 3. 窗口跨过 0 时先判定胜负 (布尔搜索，结果在胜负置换表中)，并把窗口收到该符号一侧。
+    //    窗口在 0 的一侧时不判定胜负：只需证明一个手数界，由第 1 步的手数距离剪枝限制搜索范围，
+    //    比证明任意远的胜负便宜得多
+    int alpha0 = alpha;
+    if (alpha < 0 && beta > 0) {
+        bool win = signs.solve(a, b, p);
+        if (signs.aborted()) {
+            stopped = true;
+            return 0;
+        }
+        signBounds(a, b, win, lo, hi);
+        if (lo >= beta) return lo;
+        if (hi <= alpha) return hi;
+        if (win) alpha = 0;
+        else beta = 0;
+    }
+    bool seekWin = alpha >= 0;
+    nodeCount++;
+
+    // 4. 生成着法 (带牌被支配的着法打出后各方面都不好于另一种带法，同样不必搜索)
+    size_t base = moveStack.size();
+    MoveGen gen(a, p);
+    while (true) {
+        size_t from = moveStack.size();
+        if (!gen.next(moveStack)) break;
+        pruneKicks(a, b, moveStack, from);
+    }
+    // 排序：求胜时打出后最少手数小的、炸弹在前 (最先找到最快的胜法)；否则保持生成顺序
+    size_t n = moveStack.size();
+    keyStack.resize(n);
+    for (size_t k = base; k < n; k++) {
+        Move m = moveStack[k];
+        Hand next = a;
+        m.take(next);
+        keyStack[k] = seekWin ? minPlays(next) * 2 - isBomb(m) : 0;
+    }
+    for (size_t i = base + 1; i < n; i++) {
+        Move m = moveStack[i];
+        int s = keyStack[i];
+        size_t j = i;
+        while (j > base && keyStack[j - 1] > s) {
+            moveStack[j] = moveStack[j - 1];
+            keyStack[j] = keyStack[j - 1];
+            j--;
+        }
+        moveStack[j] = m;
+        keyStack[j] = s;
+    }
+
+    // 5. alpha-beta (fail-soft)：子局面的窗口按 unshift 换算
+    int best = -SCORE_INF;
+    for (size_t k = base; k < n; k++) {
+        // 按值拷贝：递归会在栈顶继续追加，可能导致缓冲区重新分配
+        Move m = moveStack[k];
+        int bomb = isBomb(m);
+        Hand next = a;
+        m.take(next);
+        int v;
+        if (next.empty()) {
+            v = SCORE_WIN - SCORE_PLY + bomb;
+        } else {
+            int c = search(b, next, m, unshift(-beta, bomb), unshift(-alpha, bomb));
+            if (stopped) break;
+            v = -shift(c, bomb);
+        }
+        if (v > best) best = v;
+        if (v > alpha) alpha = v;
+        if (alpha >= beta) break;
+    }
+    moveStack.resize(base);
+
+    // 6. 存表：被中断的子树结果不完整，不能写入
+    if (stopped) return 0;
+    Bound type = best <= alpha0 ? Bound::UPPER : (best >= beta ? Bound::LOWER : Bound::EXACT);
+    table->store(key, best, type, a.size() + b.size());
+    return best;
+}
+
+bool ScoreSearcher::score(Hand a, Hand b, Move p, Score &s) {
+    bool win = signs.solve(a, b, p);
+    if (signs.aborted()) {
+        stopped = true;
+        return false;
+    }
+    // MTD(f)：从最有利于胜方的界出发 (胜方按最少手数出完)，每次零窗口测试把区间收紧一侧
+    int lower, upper;
+    playBounds(a, b, lower, upper);
+    signBounds(a, b, win, lower, upper);
+    int g = win ? upper : lower;
+    while (lower < upper) {
+        int beta = g == lower ? g + 1 : g;
+        g = search(a, b, p, beta - 1, beta);
+        if (stopped) return false;
+        if (g < beta) upper = g;
+        else lower = g;
+    }
+    s = Score::fromValue(g);
+    return true;
+}
+
+void scoreMoves(Hand a, Hand b, const std::vector<Move> &moves, SearchControl *control,
+                const std::function<void(size_t, const Score &)> &report) {
+    std::atomic<size_t> nextMove(0);
+    std::mutex reportMu;
+    auto work = [&]() {
+        ScoreSearcher s;
+        s.setControl(control);
+        for (size_t i; (i = nextMove.fetch_add(1)) < moves.size();) {
+            if (control && control->stopped()) break;
+            Hand next = a;
+            moves[i].take(next);
+            // 换算为 a 的视角：加上 moves[i] 这一手
+            Score r;
+            if (next.empty()) {
+                r.win = true;
+                r.plies = 0;
+                r.bombs = 0;
+            } else {
+                if (!s.score(b, next, moves[i], r)) break;
+                r.win = !r.win;
+            }
+            r.plies++;
+            r.bombs += isBomb(moves[i]);
+            std::lock_guard<std::mutex> lock(reportMu);
+            report(i, r);
+        }
+        s.flushNodes();
+    };
+
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < (size_t)threadCount() && i < moves.size(); i++) helpers.emplace_back(work);
+    work();
+    for (auto &t : helpers) t.join();
+}
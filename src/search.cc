@@ -0,0 +1,362 @@
+/**
+ * @file search.cc
+ * @brief 胜负搜索与多线程 (Lazy SMP) 调度
+ */
+
+#include "../include/search.h"
+#include "../include/pn.h"
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief 全局置换表 (Transposition Table)
+ *
+ * Key: <我方手牌(Hand::bits), 敌方手牌(Hand::bits), 上家出牌(Move::encode)>
+ * Value: 当前玩家是否必胜 (true=必胜)
+ *
+ * 固定内存预算，由 initHash() 设定大小；表项读写无锁，所有线程共享。
+ */
+static TransTable tt;
+
+/// 并行搜索线程数
+static int numThreads = 1;
+
+/// 搜索引擎
+static Engine searchEngine = Engine::DFS;
+
+static_assert((int)PaiType::PASS_T + 1 == SearchStats::TYPES, "SearchStats::moves must cover every PaiType");
+
+/// 辅助线程打乱着法顺序的层数上限 (更深的层使用相同顺序，依赖置换表共享结果)
+static const int SPLIT_PLY = 6;
+
+TransTable &sharedTable() {
+    return tt;
+}
+
+void setThreads(int n) {
+    numThreads = n < 1 ? 1 : n;
+}
+
+int threadCount() {
+    return numThreads;
+}
+
+void setEngine(Engine e) {
+    searchEngine = e;
+}
+
+Engine engine() {
+    return searchEngine;
+}
+
+bool provenResult(Hand a, Hand b, Move p, const Tablebase *tb, bool &win) {
+    // 自由出牌局面：双方张数都在残局库范围内时直接得到精确结果
+    if (tb && p.isPass() && tb->probe(a, b, win)) return true;
+
+    // 静态判定：一手出完、控制 (不生成着法)
+    if (staticWin(a, b, p)) {
+        win = true;
+        return true;
+    }
+
+    // 出牌竞速：对手只剩一个压不住的炸弹；或按最少手数拆牌后对手至多能压一手
+    if (raceLoss(a, b, p)) {
+        win = false;
+        return true;
+    }
+    if (p.isPass() && raceWin(a, b)) {
+        win = true;
+        return true;
+    }
+    return false;
+}
+
+Searcher::Searcher(int id, const std::atomic<bool> *stop, TransTable *table)
+    : id(id), ply(0), table(table ? table : &tt), tb(tablebase().ready() ? &tablebase() : nullptr),
+      stopped(false), nodeCount(0), probeCount(0), hitCount(0), stop(stop), control(nullptr), charged(0),
+      history(HISTORY_SIZE, 0) {
+    for (int i = 0; i < MAX_PLY; i++) killers[i][0] = killers[i][1] = Move::pass();
+    if (statsEnabled()) stats.reset(new SearchStats());
+    statsMark[0] = statsMark[1] = statsMark[2] = 0;
+}
+
+/// 杀手着法的排序得分 (高于其他所有得分)
+static const unsigned int KILLER_SCORE = 0xFFFFFFF0u;
+/// 属于最少手数拆法的着法的加分 (高于任何历史得分)
+static const unsigned int PLAN_BONUS = 1u << 30;
+
+void Searcher::orderMoves(Hand a, size_t base, size_t n) {
+    Move k0 = ply < MAX_PLY ? killers[ply][0] : Move::pass();
+    Move k1 = ply < MAX_PLY ? killers[ply][1] : Move::pass();
+    int plays = minPlays(a);
+    scoreStack.resize(base + n);
+    for (size_t i = base; i < base + n; i++) {
+        Move m = moveStack[i];
+        if (m == k0 && !m.isPass()) scoreStack[i] = KILLER_SCORE + 1;
+        else if (m == k1 && !m.isPass()) scoreStack[i] = KILLER_SCORE;
+        else {
+            scoreStack[i] = history[m.encode() & (HISTORY_SIZE - 1)];
+            Hand next = a;
+            m.take(next);
+            if (!m.isPass() && minPlays(next) < plays) scoreStack[i] += PLAN_BONUS;
+        }
+    }
+    // 插入排序 (稳定)：着法数通常不多，且生成顺序本身已接近有序
+    for (size_t i = base + 1; i < base + n; i++) {
+        Move m = moveStack[i];
+        unsigned int s = scoreStack[i];
+        size_t j = i;
+        while (j > base && scoreStack[j - 1] < s) {
+            moveStack[j] = moveStack[j - 1];
+            scoreStack[j] = scoreStack[j - 1];
+            j--;
+        }
+        moveStack[j] = m;
+        scoreStack[j] = s;
+    }
+}
+
+void Searcher::recordCutoff(Move m, int weight) {
+    if (ply < MAX_PLY && killers[ply][0] != m) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = m;
+    }
+    unsigned int &h = history[m.encode() & (HISTORY_SIZE - 1)];
+    h += (unsigned int)(weight * weight);
+    if (h >= PLAN_BONUS) {
+        // 防止溢出：整体减半，保持相对大小
+        for (auto &x : history) x >>= 1;
+    }
+}
+
+bool Searcher::interrupted() {
+    if (stop && stop->load(std::memory_order_relaxed)) return true;
+    if (!control) return false;
+    if (nodeCount - charged >= SearchControl::POLL_NODES) {
+        unsigned long long n = nodeCount - charged;
+        charged = nodeCount;
+        return control->charge(n);
+    }
+    return control->stopped();
+}
+
+void Searcher::flushNodes() {
+    if (control && nodeCount > charged) control->charge(nodeCount - charged);
+    charged = nodeCount;
+    flushStats();
+}
+
+void Searcher::flushStats() {
+    if (!stats) return;
+    stats->nodes = nodeCount - statsMark[0];
+    stats->probes = probeCount - statsMark[1];
+    stats->hits = hitCount - statsMark[2];
+    addStats(*stats);
+    if (control) control->addStats(*stats);
+    *stats = SearchStats();
+    statsMark[0] = nodeCount;
+    statsMark[1] = probeCount;
+    statsMark[2] = hitCount;
+}
+
+bool Searcher::solve(Hand a, Hand b, Move p) {
+    // 基础情况：如果对手已经打完牌，那么我方输了（上一轮对手赢了）
+    if (b.empty()) return false;
+
+    if (interrupted()) {
+        stopped = true;
+        return false;
+    }
+
+    // 统计开启时按阶段计时 (未开启时不读时钟)
+    unsigned long long t = stats ? statsClock() : 0;
+
+    // 0. 不需要搜索的结论：残局库、静态判定、出牌竞速
+    bool known;
+    bool proven = provenResult(a, b, p, tb, known);
+    if (stats) {
+        t = stats->lap(SearchStats::PROVEN, t);
+        stats->proven += proven;
+    }
+    if (proven) return known;
+
+    // 1. 查表 (一次探测)：以压缩空点后的规范局面为 Key
+    PositionKey key(a, b, p);
+    bool cached;
+    probeCount++;
+    bool hit = table->probe(key, cached);
+    if (stats) t = stats->lap(SearchStats::PROBE, t);
+    if (hit) {
+        hitCount++;
+        return cached;
+    }
+    unsigned long long startNodes = nodeCount++;
+    if (stats) {
+        stats->depth[ply < SearchStats::DEPTHS ? ply : SearchStats::DEPTHS - 1]++;
+        if (nodeCount - statsMark[0] >= SearchControl::POLL_NODES) flushStats();
+    }
+
+    // 2. 按牌型分阶段拉取合法走法 (追加到着法栈顶)，去掉带牌被支配的着法
+    size_t base = moveStack.size();
+    bool canWin = false;
+    Move best = Move::pass();
+    MoveGen gen(a, p);
+    while (!canWin) {
+        size_t from = moveStack.size();
+        if (!gen.next(moveStack)) break;
+        pruneKicks(a, b, moveStack, from);
+        if (stats) {
+            for (size_t k = from; k < moveStack.size(); ++k) stats->moves[(int)moveStack[k].type()]++;
+            t = stats->lap(SearchStats::GEN, t);
+        }
+
+        // 2.1 增强置换截断 (ETC)：先查子局面，已知对手必败则无需递归，其余牌型也不再生成
+        for (size_t k = from; k < moveStack.size() && !canWin; ++k) {
+            Move m = moveStack[k];
+            Hand next = a;
+            m.take(next);
+            bool oppWin;
+            if (m.isPass()) {
+                if (tb && tb->probe(b, next, oppWin) && !oppWin) canWin = true;
+            }
+            if (!canWin) {
+                if (table->probe(PositionKey(b, next, m), oppWin) && !oppWin) canWin = true;
+            }
+            if (canWin) best = m;
+        }
+        if (stats) {
+            t = stats->lap(SearchStats::ETC, t);
+            stats->etcCutoffs += canWin;
+        }
+    }
+    size_t n = moveStack.size() - base;
+
+    if (!canWin) {
+        // 2.2 杀手/历史启发排序
+        orderMoves(a, base, n);
+        if (stats) stats->lap(SearchStats::ORDER, t);
+
+        // 辅助线程在浅层从不同位置开始遍历，使各线程先搜索不同的子树
+        size_t offset = (id && ply < SPLIT_PLY && n) ? (size_t)(id * (ply + 1)) % n : 0;
+
+        ply++;
+        for (size_t k = 0; k < n; ++k) {
+            // 按值拷贝：递归会在栈顶继续追加，可能导致缓冲区重新分配
+            Move m = moveStack[base + (k + offset) % n];
+
+            // 3. 递归搜索 (Min-Max)
+            Hand next = a;
+            m.take(next);
+            // 交换角色：solve(对手, 我, 我出的牌)
+            // 如果对手必输 (!oppWin)，则我必胜
+            bool oppWin = solve(b, next, m);
+            if (stopped) break;
+
+            if (!oppWin) {
+                canWin = true;
+                best = m;
+                if (stats) {
+                    stats->cutoffs++;
+                    stats->firstCutoffs += k == 0;
+                }
+                break;
+            }
+        }
+        ply--;
+    }
+    moveStack.resize(base);
+    if (canWin && !stopped) recordCutoff(best, a.size() + b.size());
+
+    // 4. 存表 (Store Result)：被中断的子树结果不完整，不能写入
+    if (stopped) return false;
+    table->store(key, canWin, nodeCount - startNodes);
+    if (stats) stats->stores++;
+    return canWin;
+}
+
+bool solveRoot(Hand a, Hand b, Move p) {
+    return solveRoot(a, b, p, nullptr) == Outcome::WIN;
+}
+
+Outcome solveRoot(Hand a, Hand b, Move p, SearchControl *control) {
+    if (control && control->stopped()) return Outcome::UNKNOWN;
+
+    if (searchEngine == Engine::PN) {
+        // pn / dn 表在各次调用之间复用 (表项以完整局面为 Key，始终有效)
+        // 共用的搜索器不是线程安全的：并发的调用 (如服务模式下的多个会话) 依次进行
+        static PnSearcher s;
+        static std::mutex pnMu;
+        std::lock_guard<std::mutex> lock(pnMu);
+        s.setControl(control);
+        bool win = s.solve(a, b, p);
+        s.flushNodes();
+        if (s.aborted()) return Outcome::UNKNOWN;
+        return win ? Outcome::WIN : Outcome::LOSS;
+    }
+
+    if (numThreads <= 1) {
+        Searcher s;
+        s.setControl(control);
+        bool win = s.solve(a, b, p);
+        s.flushNodes();
+        if (s.aborted()) return Outcome::UNKNOWN;
+        return win ? Outcome::WIN : Outcome::LOSS;
+    }
+
+    std::atomic<bool> stop(false);
+    std::atomic<int> result(-1);
+    auto work = [&](int id) {
+        Searcher s(id, &stop);
+        s.setControl(control);
+        bool win = s.solve(a, b, p);
+        s.flushNodes();
+        if (s.aborted()) return;
+        int expected = -1;
+        result.compare_exchange_strong(expected, win ? 1 : 0);
+        stop.store(true);
+    };
+
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < numThreads; i++) helpers.emplace_back(work, i);
+    work(0);
+    for (auto &t : helpers) t.join();
+    // 所有线程都因预算耗尽而中断时没有结论
+    if (result.load() < 0) return Outcome::UNKNOWN;
+    return result.load() == 1 ? Outcome::WIN : Outcome::LOSS;
+}
+
+void solveMoves(Hand a, Hand b, const std::vector<Move> &moves, SearchControl *control,
+                const std::function<void(size_t, Outcome)> &report) {
+    if (searchEngine == Engine::PN || numThreads <= 1 || moves.size() <= 1) {
+        for (size_t i = 0; i < moves.size(); i++) {
+            Hand next = a;
+            moves[i].take(next);
+            report(i, solveRoot(b, next, moves[i], control));
+        }
+        return;
+    }
+
+    std::atomic<size_t> nextMove(0);
+    std::mutex reportMu;
+    auto work = [&]() {
+        Searcher s;
+        s.setControl(control);
+        for (size_t i; (i = nextMove.fetch_add(1)) < moves.size();) {
+            Hand next = a;
+            moves[i].take(next);
+            Outcome r = Outcome::UNKNOWN;
+            if (!(control && control->stopped())) {
+                bool win = s.solve(b, next, moves[i]);
+                if (!s.aborted()) r = win ? Outcome::WIN : Outcome::LOSS;
+            }
+            std::lock_guard<std::mutex> lock(reportMu);
+            report(i, r);
+        }
+        s.flushNodes();
+    };
+
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < (size_t)numThreads && i < moves.size(); i++) helpers.emplace_back(work);
+    work();
+    for (auto &t : helpers) t.join();
+}
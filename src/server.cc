@@ -0,0 +1,405 @@
+/**
+ * @file server.cc
+ * @brief 常驻求解服务：按行协议、多会话、会话内存上限
+ */
+
+#include "../include/server.h"
+#include "../include/tree.h"
+#include "../include/search.h"
+#include "../include/json.h"
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief 一局对弈的会话
+ *
+ * 与交互模式的 output_solution 相同：path 为从根到当前节点的路径，
+ * path.size() 为奇数时轮到 A 出牌；a、b 为当前手牌。
+ * tree、path、a、b 由 mu 保护 (分析期间一直持有)；view 是最近一次的局面回复，
+ * show 直接返回它，不等待正在进行的分析。bytes、lastUsed 由 sessionsMu 保护。
+ */
+struct Session {
+    std::mutex mu;
+    GameTree tree;
+    vector<NodeId> path;
+    int a[MAX_N + 5];
+    int b[MAX_N + 5];
+
+    std::mutex viewMu;
+    string view; ///< 最近一次的局面 (JSON，含 "session")
+
+    size_t bytes = 0;                ///< 博弈树占用的内存 (估算)
+    unsigned long long lastUsed = 0; ///< 最近一次使用的序号 (LRU 淘汰)
+};
+
+typedef std::shared_ptr<Session> SessionPtr;
+
+/**
+ * @brief 一个连接 (标准输入/输出或一个 socket 客户端)
+ *
+ * 读取线程逐行读取命令：stop 立即取消本连接的分析，其余命令排队，
+ * 由本连接的工作线程依次执行。回复与分析过程放入输出队列，由写出线程写到连接，
+ * 客户端不读取时只阻塞写出线程，不会阻塞持有会话锁的分析。
+ */
+struct Connection {
+    FILE *out;
+    SearchControl control;
+    std::mutex mu;
+    std::condition_variable ready;
+    std::deque<string> lines;
+    bool closed = false;
+    bool hungUp = false; ///< 输入在 quit 之前结束 (客户端已断开)：不再开始新的分析
+
+    std::mutex outMu;
+    std::condition_variable outReady;
+    std::deque<string> outLines;
+    bool outClosed = false;
+};
+
+/// 保护会话表与淘汰统计 (只在查找、增删会话与记账时短暂持有)
+static std::mutex sessionsMu;
+static std::map<string, SessionPtr> sessions;
+static unsigned long long useClock = 0;
+static ServerOptions options;
+
+/**
+ * @brief 淘汰最久未使用的会话，直到总内存不超过上限 (keep 不淘汰；调用方持有 sessionsMu)
+ *
+ * 被淘汰的会话若仍在分析，由执行命令的线程持有到命令结束后释放。
+ */
+static void evictSessions(const Session *keep) {
+    size_t total = 0;
+    for (auto &kv : sessions) total += kv.second->bytes;
+    while (total > (options.sessionMb << 20)) {
+        auto victim = sessions.end();
+        for (auto it = sessions.begin(); it != sessions.end(); ++it) {
+            if (it->second.get() == keep) continue;
+            if (victim == sessions.end() || it->second->lastUsed < victim->second->lastUsed) victim = it;
+        }
+        if (victim == sessions.end()) break;
+        total -= victim->second->bytes;
+        sessions.erase(victim);
+    }
+}
+
+static SessionPtr findSession(const string &sid) {
+    std::lock_guard<std::mutex> lock(sessionsMu);
+    auto it = sessions.find(sid);
+    return it == sessions.end() ? nullptr : it->second;
+}
+
+static string errorJson(const string &sid, const string &msg) {
+    string s = "{";
+    if (!sid.empty()) s += "\"session\": \"" + json_escape(sid) + "\", ";
+    return s + "\"error\": \"" + json_escape(msg) + "\"}";
+}
+
+/// 把一行回复放入连接的输出队列 (由写出线程写出)
+static void writeLine(Connection &conn, const string &line) {
+    std::lock_guard<std::mutex> lock(conn.outMu);
+    conn.outLines.push_back(line);
+    conn.outReady.notify_one();
+}
+
+static void setView(Session &s, const string &view) {
+    std::lock_guard<std::mutex> lock(s.viewMu);
+    s.view = view;
+}
+
+static string sessionPrefix(const string &sid) {
+    return "{\"session\": \"" + json_escape(sid) + "\", ";
+}
+
+/**
+ * @brief 分析会话当前节点的未证明分支 (分析过程逐行输出到连接)，返回局面的回复
+ *
+ * 调用方持有 s.mu。
+ */
+static string sessionState(const string &sid, Session &s, Connection &conn) {
+    NodeId node = s.path.back();
+    bool aTurn = s.path.size() % 2;
+    string prefix = sessionPrefix(sid);
+    if (needsAnalysis(s.tree, node)) {
+        newAnalysis();
+        {
+            // 与断开时的 cancel() 互斥：start() 会清除取消标志
+            std::lock_guard<std::mutex> lock(conn.mu);
+            conn.control.start(options.budget);
+            if (conn.hungUp) conn.control.cancel();
+        }
+        analyzeNode(s.tree, node, s.a, s.b, aTurn, &conn.control, [&](const string &line) {
+            string out = prefix + line.substr(1);
+            // 分析开始时的 "pending" 局面即为分析期间 show 的回复
+            if (line.compare(0, 9, "{\"event\":") != 0) setView(s, out);
+            writeLine(conn, out);
+        });
+    }
+    string reply = prefix + stateJson(s.tree, node, s.a, s.b, aTurn).substr(1);
+    setView(s, reply);
+    return reply;
+}
+
+/**
+ * @brief 执行一条命令
+ *
+ * 会话表只在查找与记账时短暂加锁；修改会话的命令持有该会话的锁直到分析结束，
+ * 不同会话的分析并发进行 (共享置换表)。stats 与 show 不等待正在进行的分析。
+ *
+ * @return 回复 (一行 JSON)
+ */
+static string execute(const string &line, Connection &conn) {
+    istringstream ss(line);
+    string cmd, sid;
+    ss >> cmd;
+
+    if (cmd == "stats") {
+        std::lock_guard<std::mutex> lock(sessionsMu);
+        size_t total = 0;
+        for (auto &kv : sessions) total += kv.second->bytes;
+        char buf[160];
+        snprintf(buf, sizeof(buf), "{\"sessions\": %zu, \"session_bytes\": %zu, \"session_limit\": %zu, \"hash_usage\": %.4f}",
+                 sessions.size(), total, options.sessionMb << 20, hashUsage());
+        return buf;
+    }
+    if (cmd != "new" && cmd != "play" && cmd != "back" && cmd != "show" && cmd != "close") {
+        return errorJson("", "unknown command " + cmd);
+    }
+    if (!(ss >> sid)) return errorJson("", "missing session");
+
+    SessionPtr s;
+    std::unique_lock<std::mutex> sessionLock;
+    if (cmd == "new") {
+        s = std::make_shared<Session>();
+        string error;
+        if (!parseHand(ss, s->a, error) || !parseHand(ss, s->b, error)) return errorJson(sid, error);
+        s->path.push_back(GameTree::ROOT);
+        s->view = sessionPrefix(sid) + stateJson(s->tree, GameTree::ROOT, s->a, s->b, true, true).substr(1);
+        // 先锁住新会话再放入会话表：其他连接修改它的命令等到第一次分析结束
+        sessionLock = std::unique_lock<std::mutex>(s->mu);
+        std::lock_guard<std::mutex> lock(sessionsMu);
+        sessions[sid] = s;
+    } else if (cmd == "close") {
+        std::lock_guard<std::mutex> lock(sessionsMu);
+        auto it = sessions.find(sid);
+        if (it == sessions.end()) return errorJson(sid, "unknown session");
+        sessions.erase(it);
+        return "{\"session\": \"" + json_escape(sid) + "\", \"closed\": true}";
+    } else {
+        s = findSession(sid);
+        if (!s) return errorJson(sid, "unknown session");
+        // show 只输出最近一次的局面，不重新分析，也不等待正在进行的分析
+        if (cmd == "show") {
+            std::lock_guard<std::mutex> lock(s->viewMu);
+            return s->view;
+        }
+        sessionLock = std::unique_lock<std::mutex>(s->mu);
+
+        int no = -2;
+        if (cmd == "back") no = -1;
+        if (cmd == "play" && !(ss >> no)) return errorJson(sid, "missing move id");
+        NodeId node = s->path.back();
+        if (no == -1) {
+            // 回退 (根节点不能回退)
+            if (s->path.size() > 1) {
+                s->path.pop_back();
+                s->tree[node].m.back(s->path.size() % 2 ? s->a : s->b);
+            }
+        } else if (cmd == "play") {
+            if (no < 0 || no >= (int)s->tree[node].childCount) return errorJson(sid, "invalid move id " + to_string(no));
+            NodeId next = s->tree.enter(node, no);
+            s->tree[next].m.take(s->path.size() % 2 ? s->a : s->b);
+            s->path.push_back(next);
+        }
+    }
+
+    string reply = sessionState(sid, *s, conn);
+    size_t bytes = sizeof(Session) + s->tree.bytes();
+    sessionLock.unlock();
+
+    std::lock_guard<std::mutex> lock(sessionsMu);
+    // 分析期间已被关闭、替换或淘汰的会话不再记账
+    auto it = sessions.find(sid);
+    if (it != sessions.end() && it->second == s) {
+        s->bytes = bytes;
+        s->lastUsed = ++useClock;
+        evictSessions(s.get());
+    }
+    return reply;
+}
+
+/**
+ * @brief 连接的工作线程：依次执行排队的命令
+ */
+static void workLoop(Connection *conn) {
+    for (;;) {
+        string line;
+        {
+            std::unique_lock<std::mutex> lock(conn->mu);
+            conn->ready.wait(lock, [conn] { return conn->closed || !conn->lines.empty(); });
+            if (conn->lines.empty()) return;
+            line = conn->lines.front();
+            conn->lines.pop_front();
+        }
+        if (line == "quit") return;
+        writeLine(*conn, execute(line, *conn));
+    }
+}
+
+/**
+ * @brief 连接的写出线程：依次写出输出队列中的行，直到队列关闭且写完
+ */
+static void writeLoop(Connection *conn) {
+    for (;;) {
+        string line;
+        {
+            std::unique_lock<std::mutex> lock(conn->outMu);
+            conn->outReady.wait(lock, [conn] { return conn->outClosed || !conn->outLines.empty(); });
+            if (conn->outLines.empty()) return;
+            line = conn->outLines.front();
+            conn->outLines.pop_front();
+        }
+        fputs(line.c_str(), conn->out);
+        fputc('\n', conn->out);
+        fflush(conn->out);
+    }
+}
+
+/**
+ * @brief 读取一行 (不含换行符)
+ * @return 输入结束时返回 false
+ */
+static bool readLine(FILE *in, string &line) {
+    line.clear();
+    char buf[256];
+    while (fgets(buf, sizeof(buf), in)) {
+        line += buf;
+        if (line.back() == '\n') break;
+    }
+    if (line.empty()) return false;
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r' || line.back() == ' ')) line.pop_back();
+    return true;
+}
+
+/**
+ * @brief 服务一个连接，直到输入结束或 quit
+ */
+static void serveStream(FILE *in, FILE *out) {
+    Connection conn;
+    conn.out = out;
+    std::thread writer(writeLoop, &conn);
+    std::thread worker(workLoop, &conn);
+    string line;
+    while (readLine(in, line)) {
+        if (line.empty()) continue;
+        if (line == "stop") {
+            conn.control.cancel();
+            continue;
+        }
+        // quit 之前排队的命令照常执行完 (需要立即结束时先发送 stop)
+        bool quit = line == "quit";
+        std::lock_guard<std::mutex> lock(conn.mu);
+        conn.lines.push_back(line);
+        conn.ready.notify_one();
+        if (quit) {
+            conn.closed = true;
+            break;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(conn.mu);
+        // 没有 quit 就结束的输入 (客户端断开)：丢弃排队的命令，中断正在进行的分析
+        if (!conn.closed) {
+            conn.hungUp = true;
+            conn.lines.clear();
+            conn.control.cancel();
+        }
+        conn.closed = true;
+        conn.ready.notify_one();
+    }
+    worker.join();
+    {
+        std::lock_guard<std::mutex> lock(conn.outMu);
+        conn.outClosed = true;
+        conn.outReady.notify_one();
+    }
+    writer.join();
+}
+
+int runServer(const ServerOptions &opt) {
+    options = opt;
+    if (!opt.socketPath) {
+        serveStream(stdin, stdout);
+        return 0;
+    }
+
+#ifndef _WIN32
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(opt.socketPath) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "socket path too long: %s\n", opt.socketPath);
+        return 1;
+    }
+    strcpy(addr.sun_path, opt.socketPath);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        fprintf(stderr, "cannot create socket: %s\n", strerror(errno));
+        return 1;
+    }
+    // 只删除上次遗留的 socket 文件，路径指向其他文件时报错 (不覆盖)
+    struct stat st;
+    if (lstat(opt.socketPath, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            fprintf(stderr, "%s exists and is not a socket\n", opt.socketPath);
+            close(fd);
+            return 1;
+        }
+        unlink(opt.socketPath);
+    }
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        fprintf(stderr, "cannot listen on %s: %s\n", opt.socketPath, strerror(errno));
+        close(fd);
+        return 1;
+    }
+    // 客户端断开后写回复不应终止进程
+    signal(SIGPIPE, SIG_IGN);
+    fprintf(stderr, "listening on %s\n", opt.socketPath);
+
+    for (;;) {
+        int client = accept(fd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            fprintf(stderr, "accept failed on %s\n", opt.socketPath);
+            close(fd);
+            return 1;
+        }
+        std::thread([client] {
+            FILE *in = fdopen(client, "r");
+            FILE *out = fdopen(dup(client), "w");
+            if (in && out) serveStream(in, out);
+            if (in) fclose(in);
+            if (out) fclose(out);
+        }).detach();
+    }
+#else
+    fprintf(stderr, "--server PATH (Unix socket) is not supported on Windows; use --server without PATH\n");
+    return 1;
+#endif
+}
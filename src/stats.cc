@@ -0,0 +1,100 @@
+/**
+ * @file stats.cc
+ * @brief 搜索统计的合计与输出
+ */
+
+#include "../include/stats.h"
+#include "../include/move.h"
+#include <mutex>
+
+/// 阶段名 (与 SearchStats::Phase 的顺序一致)
+static const char *const PHASE_NAMES[SearchStats::PHASES] = {"proven", "probe", "gen", "etc", "order"};
+
+static bool enabled = false;
+static std::mutex totalMu;
+static SearchStats total;
+
+void SearchStats::add(const SearchStats &o) {
+    nodes += o.nodes;
+    probes += o.probes;
+    hits += o.hits;
+    stores += o.stores;
+    proven += o.proven;
+    cutoffs += o.cutoffs;
+    firstCutoffs += o.firstCutoffs;
+    etcCutoffs += o.etcCutoffs;
+    for (int i = 0; i < TYPES; i++) moves[i] += o.moves[i];
+    for (int i = 0; i < DEPTHS; i++) depth[i] += o.depth[i];
+    for (int i = 0; i < PHASES; i++) phaseNs[i] += o.phaseNs[i];
+}
+
+std::string SearchStats::json() const {
+    char buf[128];
+    std::string s = "{\"nodes\": " + std::to_string(nodes) + ", \"tt_probes\": " + std::to_string(probes)
+                    + ", \"tt_hits\": " + std::to_string(hits) + ", \"tt_stores\": " + std::to_string(stores)
+                    + ", \"proven\": " + std::to_string(proven) + ", \"cutoffs\": " + std::to_string(cutoffs)
+                    + ", \"first_cutoffs\": " + std::to_string(firstCutoffs)
+                    + ", \"etc_cutoffs\": " + std::to_string(etcCutoffs) + ", \"moves\": {";
+    for (int i = 0; i < TYPES; i++) {
+        if (i) s += ", ";
+        s += "\"" + std::string(typeName((PaiType)i)) + "\": " + std::to_string(moves[i]);
+    }
+    // 深度直方图只输出到最后一个非零的桶
+    int last = DEPTHS;
+    while (last > 0 && !depth[last - 1]) last--;
+    s += "}, \"depth\": [";
+    for (int i = 0; i < last; i++) {
+        if (i) s += ",";
+        s += std::to_string(depth[i]);
+    }
+    s += "], \"phase_ms\": {";
+    for (int i = 0; i < PHASES; i++) {
+        snprintf(buf, sizeof(buf), "%s\"%s\": %.3f", i ? ", " : "", PHASE_NAMES[i], phaseNs[i] / 1e6);
+        s += buf;
+    }
+    return s + "}}";
+}
+
+void SearchStats::print(FILE *out) const {
+    fprintf(out, "search stats:\n");
+    fprintf(out, "  nodes         : %llu\n", nodes);
+    fprintf(out, "  tt probes     : %llu (hits %llu, %.1f%%), stores %llu\n", probes, hits,
+            probes ? 100.0 * hits / probes : 0.0, stores);
+    fprintf(out, "  proven        : %llu\n", proven);
+    fprintf(out, "  cutoffs       : %llu (first move %.1f%%), etc cutoffs %llu\n", cutoffs,
+            cutoffs ? 100.0 * firstCutoffs / cutoffs : 0.0, etcCutoffs);
+    fprintf(out, "  moves         :");
+    for (int i = 0; i < TYPES; i++) {
+        if (moves[i]) fprintf(out, " %s %llu", typeName((PaiType)i), moves[i]);
+    }
+    fprintf(out, "\n  phase ms      :");
+    for (int i = 0; i < PHASES; i++) fprintf(out, " %s %.1f", PHASE_NAMES[i], phaseNs[i] / 1e6);
+    fprintf(out, "\n  depth         :");
+    for (int i = 0; i < DEPTHS; i++) {
+        if (depth[i]) fprintf(out, " %d:%llu", i, depth[i]);
+    }
+    fprintf(out, "\n");
+}
+
+void enableStats(bool on) {
+    enabled = on;
+}
+
+bool statsEnabled() {
+    return enabled;
+}
+
+void addStats(const SearchStats &s) {
+    std::lock_guard<std::mutex> lock(totalMu);
+    total.add(s);
+}
+
+SearchStats totalStats() {
+    std::lock_guard<std::mutex> lock(totalMu);
+    return total;
+}
+
+void resetStats() {
+    std::lock_guard<std::mutex> lock(totalMu);
+    total = SearchStats();
+}
@@ -0,0 +1,225 @@
+/**
+ * @file tablebase.cc
+ * @brief 小残局库的编号、逐层生成与文件读写
+ */
+
+#include "../include/tablebase.h"
+#include "../include/search.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 残局库文件头
+ */
+struct TBFileHeader {
+    char magic[8];                 ///< "NEODOUTB"
+    unsigned int version;          ///< TB_FILE_VERSION
+    unsigned int cards;            ///< 每方最大张数
+    unsigned long long hands;      ///< 手牌数 (行数 = 列数)
+    unsigned long long rowWords;   ///< 每行的 64 位字数
+};
+
+static const char TB_MAGIC[8] = {'N', 'E', 'O', 'D', 'O', 'U', 'T', 'B'};
+
+/// 生成时每个线程的置换表大小 (MB)，用于一轮出牌之内的局面
+static const size_t TB_BUILD_HASH_MB = 16;
+
+/// 点数 r 的最大张数
+static int maxCount(int r) {
+    return r >= 16 ? 1 : 4;
+}
+
+Tablebase::Tablebase() : maxCards(0), handCount(0), rowWords(0), words(nullptr) {
+    memset(prefix, 0, sizeof(prefix));
+}
+
+Tablebase::~Tablebase() { release(); }
+
+void Tablebase::release() {
+    free((void *)words);
+    words = nullptr;
+    maxCards = 0;
+    handCount = 0;
+    rowWords = 0;
+}
+
+bool Tablebase::allocate(int cards) {
+    release();
+    // ways[i][k]：点数 i+3 .. 大王 合计不超过 k 张的方案数
+    size_t ways[16][TB_MAX_CARDS + 1];
+    for (int k = 0; k <= cards; k++) ways[15][k] = 1;
+    for (int i = 14; i >= 0; i--) {
+        for (int k = 0; k <= cards; k++) {
+            ways[i][k] = 0;
+            for (int c = 0; c <= maxCount(i + 3) && c <= k; c++) ways[i][k] += ways[i + 1][k - c];
+        }
+    }
+    memset(prefix, 0, sizeof(prefix));
+    for (int i = 0; i < 15; i++) {
+        for (int k = 0; k <= cards; k++) {
+            size_t sum = 0;
+            for (int c = 0; c <= maxCount(i + 3) && c <= k; c++) {
+                prefix[i][k][c] = sum;
+                sum += ways[i + 1][k - c];
+            }
+        }
+    }
+
+    size_t hands = ways[0][cards];
+    size_t row = (hands + 63) / 64;
+    words = (std::atomic<unsigned long long> *)calloc(hands * row, sizeof(unsigned long long));
+    if (!words) return false;
+    maxCards = cards;
+    handCount = hands;
+    rowWords = row;
+    return true;
+}
+
+/**
+ * @brief 枚举所有不超过 cards 张的手牌，按张数分组
+ */
+static void enumHands(int r, Hand h, int size, int cards, std::vector<std::vector<Hand> > &out) {
+    if (r == MAX_N) {
+        out[size].push_back(h);
+        return;
+    }
+    for (int c = 0; c <= maxCount(r) && size + c <= cards; c++) {
+        Hand next;
+        next.bits = h.bits + ((unsigned long long)c << Hand::shift(r));
+        enumHands(r + 1, next, size + c, cards, out);
+    }
+}
+
+/// 两手牌能否同时出现 (每个点数合计不超过 4 张，大小王各 1 张)
+static bool compatible(Hand a, Hand b) {
+    for (int r = 3; r < MAX_N; r++) {
+        if (a.count(r) + b.count(r) > maxCount(r)) return false;
+    }
+    return true;
+}
+
+bool Tablebase::build(int cards, int workers, std::string &err) {
+    if (cards < 1 || cards > TB_MAX_CARDS) {
+        err = "tablebase size must be 1-" + to_string(TB_MAX_CARDS);
+        return false;
+    }
+    if (!allocate(cards)) {
+        err = "cannot allocate the tablebase";
+        return false;
+    }
+    if (workers < 1) workers = 1;
+
+    std::vector<std::vector<Hand> > bySize(cards + 1);
+    enumHands(3, Hand(), 0, cards, bySize);
+
+    std::vector<TransTable> tables(workers);
+    for (auto &t : tables) {
+        if (!t.resize(TB_BUILD_HASH_MB)) {
+            err = "cannot allocate the hash table";
+            return false;
+        }
+    }
+
+    for (int total = 1; total <= 2 * cards; total++) {
+        // 本层的任务：(a 的张数, a 在该组中的下标)，每个任务求解一整行
+        std::vector<std::pair<int, size_t> > jobs;
+        for (int sa = total - cards < 1 ? 1 : total - cards; sa <= cards && sa <= total; sa++) {
+            if (total - sa < 1) continue;
+            for (size_t i = 0; i < bySize[sa].size(); i++) jobs.push_back(std::make_pair(sa, i));
+        }
+
+        std::atomic<size_t> next(0);
+        auto work = [&](int id) {
+            Searcher s(0, nullptr, &tables[id]);
+            s.useTablebase(this);
+            std::vector<Move> moves;
+            for (size_t j; (j = next.fetch_add(1)) < jobs.size(); ) {
+                Hand a = bySize[jobs[j].first][jobs[j].second];
+                const std::vector<Hand> &column = bySize[total - jobs[j].first];
+                size_t ia = rank(a);
+                moves.clear();
+                genLegalMoves(a, Move::pass(), moves);
+                for (Hand b : column) {
+                    if (!compatible(a, b)) continue;
+                    // 根节点手工展开：本层的自由出牌局面尚未入表，只有一轮结束后的局面可以查表
+                    for (Move m : moves) {
+                        Hand next = a;
+                        m.take(next);
+                        if (!s.solve(b, next, m)) {
+                            set(ia, rank(b));
+                            break;
+                        }
+                    }
+                }
+            }
+        };
+
+        std::vector<std::thread> helpers;
+        for (int i = 1; i < workers; i++) helpers.emplace_back(work, i);
+        work(0);
+        for (auto &t : helpers) t.join();
+        fprintf(stderr, "tablebase: %d cards done (%zu rows)\n", total, jobs.size());
+    }
+    return true;
+}
+
+bool Tablebase::save(const char *path, std::string &err) const {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        err = string("cannot open ") + path;
+        return false;
+    }
+    TBFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, TB_MAGIC, sizeof(TB_MAGIC));
+    h.version = TB_FILE_VERSION;
+    h.cards = maxCards;
+    h.hands = handCount;
+    h.rowWords = rowWords;
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1
+           && fwrite((const void *)words, sizeof(unsigned long long), handCount * rowWords, f) == handCount * rowWords;
+    ok = fclose(f) == 0 && ok;
+    if (!ok) err = string("cannot write ") + path;
+    return ok;
+}
+
+bool Tablebase::load(const char *path, std::string &err) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        err = string("cannot open ") + path;
+        return false;
+    }
+    TBFileHeader h;
+    if (fread(&h, sizeof(h), 1, f) != 1 || memcmp(h.magic, TB_MAGIC, sizeof(TB_MAGIC)) != 0) {
+        fclose(f);
+        err = string(path) + ": not a tablebase file";
+        return false;
+    }
+    if (h.version != TB_FILE_VERSION || h.cards < 1 || h.cards > (unsigned int)TB_MAX_CARDS) {
+        fclose(f);
+        err = string(path) + ": incompatible tablebase version";
+        return false;
+    }
+    if (!allocate((int)h.cards) || h.hands != handCount || h.rowWords != rowWords) {
+        release();
+        fclose(f);
+        err = string(path) + ": corrupt tablebase header";
+        return false;
+    }
+    bool ok = fread((void *)words, sizeof(unsigned long long), handCount * rowWords, f) == handCount * rowWords;
+    fclose(f);
+    if (!ok) {
+        release();
+        err = string(path) + ": truncated tablebase file";
+        return false;
+    }
+    return true;
+}
+
+Tablebase &tablebase() {
+    static Tablebase tb;
+    return tb;
+}
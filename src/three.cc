@@ -0,0 +1,247 @@
+/**
+ * @file three.cc
+ * @brief 三人局面 (地主 vs 农民) 的搜索
+ */
+
+#include "../include/three.h"
+#include "../include/tt.h"
+#include "../include/plays.h"
+#include "../include/eval.h"
+#include <cstdlib>
+#include <memory>
+
+static const unsigned long long WIN_FLAG = 1ULL << 32;
+static const unsigned long long USED_FLAG = 1ULL << 33;
+static const int WORK_SHIFT = 34;
+static const unsigned long long KEY_META_MASK = 0xFFFFFFFFULL;
+
+ThreeSearcher::ThreeSearcher(size_t mb)
+    : control(nullptr), charged(0), stopped(false), nodeCount(0), entries(nullptr), entryMask(0) {
+    for (auto &row : history) row.assign(HISTORY_SIZE, 0);
+    size_t n = 2;
+    while (n * 2 * sizeof(Entry) <= (mb << 20)) n *= 2;
+    // calloc 的清零页按需提供，未触及的部分不占用物理内存
+    entries = (Entry *)calloc(n, sizeof(Entry));
+    if (entries) entryMask = n - 1;
+}
+
+ThreeSearcher::~ThreeSearcher() { free(entries); }
+
+bool ThreeSearcher::interrupted() {
+    if (!control) return false;
+    if (nodeCount - charged >= SearchControl::POLL_NODES) {
+        unsigned long long n = nodeCount - charged;
+        charged = nodeCount;
+        return control->charge(n);
+    }
+    return control->stopped();
+}
+
+void ThreeSearcher::flushNodes() {
+    if (control && nodeCount > charged) control->charge(nodeCount - charged);
+    charged = nodeCount;
+}
+
+ThreeSearcher::Key ThreeSearcher::makeKey(const ThreeState &s) {
+    Key k;
+    Hand h[SEATS] = {s.hand[0], s.hand[1], s.hand[2]};
+    compressGaps(h, SEATS);
+    // 当前座位 PASS 后下一座位仍要压过 last，因此两人的约束都要记录
+    unsigned long long code = responseCode(s.hand[s.turn], s.last);
+    if (!s.last.isPass() && s.passes == 0) {
+        code |= (unsigned long long)responseCode(s.hand[(s.turn + 1) % SEATS], s.last) << 14;
+    }
+    k.meta = code | ((unsigned long long)s.turn << 28) | ((unsigned long long)s.passes << 30);
+
+    unsigned long long x = k.meta * 0x165667B19E3779F9ULL;
+    for (int i = 0; i < SEATS; i++) {
+        k.hand[i] = h[i].bits;
+        x ^= h[i].bits * 0x9E3779B97F4A7C15ULL;
+        x = (x << 23) | (x >> 41);
+    }
+    x ^= x >> 29;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    k.hash = x ^ (x >> 32);
+    return k;
+}
+
+bool ThreeSearcher::lookup(const Key &k, bool &win) const {
+    if (!entries) return false;
+    // 两路组相联：同一条缓存行中的两个表项
+    size_t i = k.hash & entryMask & ~(size_t)1;
+    for (size_t j = i; j < i + 2; j++) {
+        const Entry &e = entries[j];
+        if ((e.meta & USED_FLAG) && (e.meta & KEY_META_MASK) == k.meta && e.hand[0] == k.hand[0]
+            && e.hand[1] == k.hand[1] && e.hand[2] == k.hand[2]) {
+            win = (e.meta & WIN_FLAG) != 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreeSearcher::save(const Key &k, bool win, unsigned long long work) {
+    if (!entries) return;
+    size_t i = k.hash & entryMask & ~(size_t)1;
+    size_t victim = i;
+    for (size_t j = i; j < i + 2; j++) {
+        const Entry &e = entries[j];
+        // 空位或同一局面 (重新证明时原地覆盖，不占用第二个表项)
+        if (!(e.meta & USED_FLAG) || ((e.meta & KEY_META_MASK) == k.meta && e.hand[0] == k.hand[0]
+                                      && e.hand[1] == k.hand[1] && e.hand[2] == k.hand[2])) {
+            victim = j;
+            break;
+        }
+        // 淘汰子树搜索量较小的表项
+        if ((e.meta >> WORK_SHIFT) < (entries[victim].meta >> WORK_SHIFT)) victim = j;
+    }
+    if (work >> (64 - WORK_SHIFT)) work = (1ULL << (64 - WORK_SHIFT)) - 1;
+    Entry &e = entries[victim];
+    for (int s = 0; s < SEATS; s++) e.hand[s] = k.hand[s];
+    e.meta = k.meta | (win ? WIN_FLAG : 0) | USED_FLAG | (work << WORK_SHIFT);
+}
+
+/**
+ * @brief 对手一方的合并手牌：每个点数取各人张数的较大者
+ *
+ * 任何一个对手能出的牌合并后都能出，以它作为对手做静态判定是保守的 (仍然是严格证明)。
+ */
+static Hand strongest(Hand x, Hand y) {
+    Hand h;
+    h.bits = 0;
+    for (int r = 3; r < MAX_N; r++) {
+        h.bits |= (unsigned long long)(x.count(r) > y.count(r) ? x.count(r) : y.count(r)) << Hand::shift(r);
+    }
+    return h;
+}
+
+/// 属于最少手数拆法的着法的加分 (高于任何历史得分)
+static const unsigned int PLAN_BONUS = 1u << 29;
+/// 需要压过的牌是队友出的时，PASS 排在最前
+static const unsigned int PASS_FIRST = 1u << 31;
+
+void ThreeSearcher::orderMoves(const ThreeState &s, size_t base, size_t n) {
+    Hand a = s.hand[s.turn];
+    int next = (s.turn + 1) % SEATS;
+    int lastSeat = (s.turn + SEATS - 1 - s.passes) % SEATS;
+    int plays = minPlays(a);
+    scoreStack.resize(base + n);
+    for (size_t i = base; i < base + n; i++) {
+        Move m = moveStack[i];
+        unsigned int score;
+        if (m.isPass()) {
+            // 队友出的牌：让队友继续控制
+            score = lastSeat != s.turn && sameTeam(lastSeat, s.turn) ? PASS_FIRST : 0;
+        } else {
+            Hand rest = a;
+            m.take(rest);
+            score = 1 + history[s.turn][m.encode() & (HISTORY_SIZE - 1)];
+            if (minPlays(rest) < plays) score += PLAN_BONUS;
+            // 下家是对手且压不住
+            if (!sameTeam(next, s.turn) && !canBeat(s.hand[next], m)) score += PLAN_BONUS;
+        }
+        scoreStack[i] = score;
+    }
+    // 插入排序 (稳定)
+    for (size_t i = base + 1; i < base + n; i++) {
+        Move m = moveStack[i];
+        unsigned int sc = scoreStack[i];
+        size_t j = i;
+        while (j > base && scoreStack[j - 1] < sc) {
+            moveStack[j] = moveStack[j - 1];
+            scoreStack[j] = scoreStack[j - 1];
+            j--;
+        }
+        moveStack[j] = m;
+        scoreStack[j] = sc;
+    }
+}
+
+void ThreeSearcher::recordCutoff(int seat, Move m, int weight) {
+    unsigned int &h = history[seat][m.encode() & (HISTORY_SIZE - 1)];
+    h += (unsigned int)(weight * weight);
+    if (h >= PLAN_BONUS) {
+        // 防止溢出：整体减半，保持相对大小
+        for (auto &row : history) {
+            for (auto &x : row) x >>= 1;
+        }
+    }
+}
+
+bool ThreeSearcher::search(const ThreeState &s) {
+    unsigned long long startNodes = nodeCount++;
+    if (interrupted()) {
+        stopped = true;
+        return false;
+    }
+
+    // 0. 一手出完；自由出牌时的控制与出牌竞速判定 (队友总可以 PASS，只需考虑对手)
+    Hand a = s.hand[s.turn];
+    if (oneMoveFinish(a, s.last)) return true;
+    if (s.last.isPass()) {
+        Hand opp = s.turn == 0 ? strongest(s.hand[1], s.hand[2]) : s.hand[0];
+        if (staticWin(a, opp, s.last) || raceWin(a, opp)) return true;
+    }
+
+    // 1. 查表
+    Key key = makeKey(s);
+    bool cached;
+    if (lookup(key, cached)) return cached;
+
+    // 2. 生成并排序着法 (追加到着法栈顶)
+    size_t base = moveStack.size();
+    genLegalMoves(a, s.last, moveStack);
+    size_t n = moveStack.size() - base;
+    orderMoves(s, base, n);
+
+    // 3. 递归：下一个出牌者是队友时沿用其结果，否则取反
+    bool canWin = false;
+    for (size_t k = 0; k < n; k++) {
+        Move m = moveStack[base + k];
+        ThreeState next = s.after(m);
+        if (next.hand[s.turn].empty()) {
+            canWin = true;
+            break;
+        }
+        bool r = search(next);
+        if (stopped) break;
+        if (sameTeam(s.turn, next.turn) ? r : !r) {
+            canWin = true;
+            recordCutoff(s.turn, m, a.size());
+            break;
+        }
+    }
+    moveStack.resize(base);
+
+    // 4. 存表：被中断的子树结果不完整，不能写入
+    if (stopped) return false;
+    save(key, canWin, nodeCount - startNodes);
+    return canWin;
+}
+
+bool ThreeSearcher::solve(const ThreeState &s) {
+    stopped = false;
+    // 已有人出完：上一个出牌者所在阵营获胜
+    int done = s.finished();
+    if (done >= 0) return sameTeam(done, s.turn);
+    return search(s);
+}
+
+static std::unique_ptr<ThreeSearcher> threeSearcher;
+
+bool initThree(size_t mb) {
+    threeSearcher.reset(new ThreeSearcher(mb));
+    return threeSearcher->ready();
+}
+
+Outcome solveThreeMove(const ThreeState &s, Move m, SearchControl *control) {
+    if (control && control->stopped()) return Outcome::UNKNOWN;
+    ThreeState next = s.after(m);
+    if (next.hand[s.turn].empty()) return Outcome::WIN;
+    if (!threeSearcher) initThree(64);
+    threeSearcher->setControl(control);
+    bool r = threeSearcher->solve(next);
+    threeSearcher->flushNodes();
+    if (threeSearcher->aborted()) return Outcome::UNKNOWN;
+    return (sameTeam(s.turn, next.turn) ? r : !r) ? Outcome::WIN : Outcome::LOSS;
+}
@@ -1,15 +1,21 @@
 /**
  * @file tree.cc
- * @brief 博弈树搜索算法实现
+ * @brief 博弈树节点与分析入口
  * 
- * 包含 Min-Max 搜索算法、Alpha-Beta 剪枝优化（隐含在循环中断中）、
- * 状态压缩与哈希表记忆化（Memoization）实现。
+ * 交互界面使用的 Node 树以及置换表的配置接口；
+ * Min-Max 搜索本身（含剪枝、置换表、多线程）见 search.cc。
  */
 
 #include "../include/pai.h"
 #include "../include/tree.h"
+#include "../include/search.h"
+#include "../include/score.h"
+#include "../include/plays.h"
+#include "../include/json.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <vector>
-#include <unordered_map>
 
 /**
  * @brief 检查手牌是否已打完
@@ -23,158 +29,324 @@ bool checkEmpty(int *a) {
     return true;
 }
 
-Node::Node() : win(false), p(new PASS()) {}
-
-Node::Node(Pai *p, bool win) : p(p), win(win) {}
-
 // ==========================================
-// 状态压缩与哈希表 (State Compression & Hash)
+// 博弈树 (节点池)
 // ==========================================
 
-/**
- * @brief 自定义哈希函数，用于 unordered_map 的 Key (std::tuple)
- */
-struct KeyHash {
-    std::size_t operator()(const std::tuple<unsigned long long, unsigned long long, unsigned int>& k) const {
-        // 简单的异或哈希组合
-        auto h1 = std::hash<unsigned long long>{}(std::get<0>(k));
-        auto h2 = std::hash<unsigned long long>{}(std::get<1>(k));
-        auto h3 = std::hash<unsigned int>{}(std::get<2>(k));
-        return h1 ^ (h2 << 1) ^ (h3 << 2); 
+const NodeId GameTree::ROOT;
+
+GameTree::GameTree() {
+    Node root;
+    root.m = Move::pass();
+    root.child = 0;
+    root.childCount = 0;
+    root.win = false;
+    root.known = false;
+    root.scored = false;
+    nodes.push_back(root);
+}
+
+void GameTree::addChildren(NodeId id, const vector<Move> &moves) {
+    unsigned int n = (unsigned int)moves.size();
+    NodeId first;
+    auto it = freeBlocks.find(n);
+    if (it != freeBlocks.end() && !it->second.empty()) {
+        // 复用同样大小的空闲块
+        first = it->second.back();
+        it->second.pop_back();
+    } else {
+        first = (NodeId)nodes.size();
+        nodes.resize(nodes.size() + n);
+    }
+    for (unsigned int i = 0; i < n; i++) {
+        Node &c = nodes[first + i];
+        c.m = moves[i];
+        c.childCount = 0;
+        c.win = false;
+        c.known = false;
+        c.scored = false;
     }
-};
+    nodes[id].child = first;
+    nodes[id].childCount = n;
+}
 
-/**
- * @brief 全局记忆化表 (Memoization Table)
- * 
- * Key: <我方手牌(压缩), 敌方手牌(压缩), 上家出牌(压缩)>
- * Value: 当前玩家是否必胜 (true=必胜)
- */
-std::unordered_map<std::tuple<unsigned long long, unsigned long long, unsigned int>, bool, KeyHash> memo;
+void GameTree::releaseChildren(NodeId id) {
+    Node &node = nodes[id];
+    if (!node.childCount) return;
+    for (unsigned int i = 0; i < node.childCount; i++) releaseChildren(node.child + i);
+    freeBlocks[node.childCount].push_back(node.child);
+    node.childCount = 0;
+}
 
-/**
- * @brief 手牌压缩函数
- * 
- * 将 15 种牌（3-大王）的数量（每种0-4张）压缩到一个 uint64_t 中。
- * 每种牌占用 3 bits (2^3=8 > 4)。
- * 
- * @param arr 手牌数组
- * @return 压缩后的 64 位整数
- */
-unsigned long long encodeHand(int *arr) {
-    unsigned long long code = 0;
-    for (int i = 3; i < MAX_N; i++) {
-        code |= ((unsigned long long)arr[i] & 0x7) << ((i - 3) * 3);
+NodeId GameTree::enter(NodeId parent, int i) {
+    for (unsigned int k = 0; k < nodes[parent].childCount; k++) {
+        if ((int)k != i) releaseChildren(child(parent, k));
     }
-    return code;
+    return child(parent, i);
 }
 
-/**
- * @brief 牌型压缩函数
- * @param p 牌型对象
- * @return 压缩后的 32 位整数
- */
-unsigned int encodePai(Pai *p) {
-    if (!p) return 0;
-    return p->encode();
+size_t GameTree::bytes() const {
+    size_t n = nodes.capacity() * sizeof(Node);
+    for (auto &kv : freeBlocks) n += kv.second.capacity() * sizeof(NodeId);
+    return n;
 }
 
 // ==========================================
-// 核心求解算法 (Solver)
+// 置换表 (Transposition Table)
 // ==========================================
 
+/// 默认置换表大小 (MB)
+static const size_t DEFAULT_HASH_MB = 256;
+
+bool initHash(size_t mb) {
+    return sharedTable().resize(mb);
+}
+
+bool initHashFile(const char *path, size_t mb, string &err) {
+    return sharedTable().mapFile(path, mb, err);
+}
+
+double hashUsage() {
+    return sharedTable().occupancy();
+}
+
+void newAnalysis() {
+    sharedTable().newSearch();
+    scoreTable().newSearch();
+}
+
 /**
- * @brief 快速求解函数 (Zero-Allocation Solver)
- * 
- * 纯递归函数，不创建 Node 对象，用于快速判定胜负。
+ * @brief 为每个合法着法建立子节点 (已建立时不变)
+ */
+static void addChildren(GameTree &tree, NodeId root, int *a) {
+    if (tree[root].childCount) return;
+    vector<Move> t;
+    genLegalMoves(Hand::fromArray(a), tree[root].m, t);
+    tree.addChildren(root, t);
+}
+
+/**
+ * @brief 构建第一层博弈树节点
  * 
- * @param a 当前玩家手牌
- * @param b 对手玩家手牌
- * @param p 上家打出的牌
- * @return true 如果当前玩家(a)必胜
+ * 用于 UI 显示当前可选的走法：列出全部着法，并用 solveMoves() 并行求解
+ * 所有尚未证明的分支 (已证明的分支直接复用，回退、前进时不再重算)。
  */
-bool solve(int *a, int *b, Pai *p) {
-    // 基础情况：如果对手已经打完牌，那么我方输了（上一轮对手赢了）
-    if (checkEmpty(b)) return false; 
-    
-    // 1. 查表 (Memoization Lookup)
-    unsigned long long ha = encodeHand(a);
-    unsigned long long hb = encodeHand(b);
-    unsigned int hp = encodePai(p);
-    
-    auto key = std::make_tuple(ha, hb, hp);
+void getTree(GameTree &tree, NodeId root, int *a, int *b, SearchControl *control, const std::function<void(int)> &report) {
+    if (checkEmpty(b)) {
+        tree[root].win = false;
+        tree[root].known = true;
+        return ;
+    }
     
-    if (memo.count(key)) {
-        return memo[key];
+    if (sharedTable().capacity() == 0) initHash(DEFAULT_HASH_MB);
+
+    addChildren(tree, root, a);
+    vector<Move> t;
+    vector<int> index;
+    for (int i = 0; i < (int)tree[root].childCount; i++) {
+        const Node &c = tree[tree.child(root, i)];
+        if (c.known) continue;
+        t.push_back(c.m);
+        index.push_back(i);
     }
 
-    // 2. 生成所有合法走法
-    vector<Pai *> moves = Pai::getLegalPai(a, p);
-    
+    // node.win 定义为：走到该节点 (即 A 出了 node.m) 后，接下来的玩家 (B) 能否必胜
+    solveMoves(Hand::fromArray(a), Hand::fromArray(b), t, control, [&](size_t k, Outcome r) {
+        Node &node = tree[tree.child(root, index[k])];
+        node.win = r == Outcome::WIN;
+        node.known = r != Outcome::UNKNOWN;
+        if (report && node.known) report(index[k]);
+    });
+
+    // 有一步能让 B 必败则 A 必胜；否则只有全部分支都已证明 B 必胜，才能确定 A 必败
+    bool win = false, known = true;
+    for (int i = 0; i < (int)tree[root].childCount; i++) {
+        const Node &c = tree[tree.child(root, i)];
+        if (c.known && !c.win) win = true;
+        if (!c.known) known = false;
+    }
+    tree[root].win = win;
+    tree[root].known = win || known;
+
+    // 分值：只对已证明的分支求 (胜负决定了分值的符号)
+    if (!scoreEnabled()) return;
+    t.clear();
+    index.clear();
+    for (int i = 0; i < (int)tree[root].childCount; i++) {
+        const Node &c = tree[tree.child(root, i)];
+        if (!c.known || c.scored) continue;
+        t.push_back(c.m);
+        index.push_back(i);
+    }
+    scoreMoves(Hand::fromArray(a), Hand::fromArray(b), t, control, [&](size_t k, const Score &s) {
+        Node &node = tree[tree.child(root, index[k])];
+        node.scored = true;
+        node.plies = (unsigned char)s.plies;
+        node.bombs = (unsigned char)s.bombs;
+        if (report) report(index[k]);
+    });
+}
+
+/**
+ * @brief 已求出分值的分支对当前玩家的分值
+ */
+static int childValue(const Node &c) {
+    Score s;
+    s.win = !c.win;
+    s.plies = c.plies;
+    s.bombs = c.bombs;
+    return s.value();
+}
+
+int bestChild(const GameTree &tree, NodeId node, int *hand) {
+    // 分值：必胜分支中取最快取胜的；全部必败 (均已证明) 时取最慢落败的
     bool canWin = false;
-    for (size_t i = 0; i < moves.size(); ++i) {
-        // 如果已经找到必胜路径，后续只需清理内存
-        if (canWin) {
-            delete moves[i];
+    for (int i = 0; i < (int)tree[node].childCount; i++) {
+        const Node &c = tree[tree.child(node, i)];
+        if (c.known && !c.win) canWin = true;
+    }
+    if (canWin || !hasUnknown(tree, node)) {
+        int scored = -1, value = 0;
+        for (int i = 0; i < (int)tree[node].childCount; i++) {
+            const Node &c = tree[tree.child(node, i)];
+            if (!c.scored || (canWin && c.win)) continue;
+            if (scored < 0 || childValue(c) > value) {
+                scored = i;
+                value = childValue(c);
+            }
+        }
+        if (scored >= 0) return scored;
+    }
+
+    int best = -1, bestPlays = 0;
+    Hand h = Hand::fromArray(hand);
+    for (int i = 0; i < (int)tree[node].childCount; i++) {
+        const Node &c = tree[tree.child(node, i)];
+        if (c.known && !c.win) return i;
+        if (c.known) {
+            if (best < 0) best = i;
             continue;
         }
+        // 未证明的分支：打出后剩余手牌越容易出完越好
+        Hand next = h;
+        c.m.take(next);
+        int plays = minPlays(next);
+        if (best < 0 || tree[tree.child(node, best)].known || plays < bestPlays) {
+            best = i;
+            bestPlays = plays;
+        }
+    }
+    return best;
+}
+
+bool hasUnknown(const GameTree &tree, NodeId node) {
+    for (int i = 0; i < (int)tree[node].childCount; i++) {
+        if (!tree[tree.child(node, i)].known) return true;
+    }
+    return false;
+}
+
+bool needsAnalysis(const GameTree &tree, NodeId node) {
+    if (!tree[node].childCount || hasUnknown(tree, node)) return true;
+    if (!scoreEnabled()) return false;
+    for (int i = 0; i < (int)tree[node].childCount; i++) {
+        if (!tree[tree.child(node, i)].scored) return true;
+    }
+    return false;
+}
+
+string optionJson(const GameTree &tree, NodeId node, int i) {
+    const Node &c = tree[tree.child(node, i)];
+    const char *win = !c.known ? "null" : (c.win ? "true" : "false");
+    string s = "{\"id\": " + to_string(i) + ", \"desc\": \"" + json_escape(describeMove(c.m)) + "\", \"win\": " + win;
+    if (scoreEnabled()) {
+        if (c.scored) s += ", \"plies\": " + to_string(c.plies) + ", \"bombs\": " + to_string(c.bombs);
+        else s += ", \"plies\": null, \"bombs\": null";
+    }
+    return s + "}";
+}
 
-        // 3. 递归搜索 (Min-Max)
-        moves[i]->take(a);
-        // 交换角色：solve(对手, 我, 我出的牌)
-        // 如果对手必输 (!oppWin)，则我必胜
-        bool oppWin = solve(b, a, moves[i]);
-        moves[i]->back(a);
-        
-        delete moves[i]; // 立即释放内存
-
-        if (!oppWin) {
-            canWin = true;
-            // 找到赢法后不立即 break，而是继续循环以清理剩余 moves 的内存
+string stateJson(const GameTree &tree, NodeId node, int *a, int *b, bool aTurn, bool pending) {
+    string s = "{";
+    s += "\"turn\": \"" + string(aTurn ? "A" : "B") + "\",";
+    s += "\"hand_a\": " + json_hand(Hand::fromArray(a)) + ",";
+    s += "\"hand_b\": " + json_hand(Hand::fromArray(b)) + ",";
+    if (checkEmpty(a)) {
+        s += "\"game_over\": true, \"winner\": \"A\", \"options\": []";
+    } else if (checkEmpty(b)) {
+        s += "\"game_over\": true, \"winner\": \"B\", \"options\": []";
+    } else {
+        s += "\"game_over\": false, \"winner\": null, \"options\": [";
+        for (int i = 0; i < (int)tree[node].childCount; i++) {
+            if (i > 0) s += ",";
+            s += optionJson(tree, node, i);
         }
+        s += "], \"complete\": " + string(hasUnknown(tree, node) ? "false" : "true");
+        s += ", \"best\": " + to_string(bestChild(tree, node, aTurn ? a : b));
+        if (pending) s += ", \"pending\": true";
     }
-    
-    // 4. 存表 (Store Result)
-    memo[key] = canWin;
-    return canWin;
+    return s + "}";
+}
+
+string progressJson(const SearchControl *control, int proven, int total) {
+    double ms = control->elapsedMs();
+    char buf[160];
+    snprintf(buf, sizeof(buf), "{\"event\": \"progress\", \"proven\": %d, \"options\": %d, \"nodes\": %llu, \"time_ms\": %.1f, \"knps\": %.1f",
+             proven, total, control->nodes(), ms, ms > 0 ? control->nodes() / ms : 0.0);
+    string s = buf;
+    if (statsEnabled()) s += ", \"stats\": " + control->stats().json();
+    return s + "}";
 }
 
 /**
- * @brief 构建第一层博弈树节点
- * 
- * 用于 UI 显示当前可选的走法。
- * 内部调用 solve() 快速计算子节点的胜负状态。
+ * @brief 已证明的分支数
  */
-void getTree(Node *root, int *a, int *b) {
-    if (checkEmpty(b)) {
-        root->win = false;
-        return ;
+static int provenCount(const GameTree &tree, NodeId node) {
+    int n = 0;
+    for (int i = 0; i < (int)tree[node].childCount; i++) n += tree[tree.child(node, i)].known;
+    return n;
+}
+
+void analyzeNode(GameTree &tree, NodeId node, int *a, int *b, bool aTurn, SearchControl *control,
+                 const std::function<void(const string &)> &emit) {
+    int *hand = aTurn ? a : b;
+    int *opp = aTurn ? b : a;
+    // 上一手已经出完：游戏结束
+    if (checkEmpty(opp)) return;
+    addChildren(tree, node, hand);
+    if (!needsAnalysis(tree, node)) return;
+    if (!emit) {
+        getTree(tree, node, hand, opp, control, nullptr);
+        return;
     }
-    
-    vector<Pai *> t = Pai::getLegalPai(a, root->p);
-    for (int i = 0; i < t.size(); i++) {
-        Node *node = new Node(t[i], 0);
-        t[i]->take(a);
-        
-        // 使用 solve 快速判断子节点状态
-        // solve(b, a, t[i]) 返回 true 表示 B 必胜
-        // 如果 B 必胜，则对于 A 来说 node->win 是 false（但这通常记录的是该节点代表的局面是否对当前出牌者有利？）
-        // 这里定义 node->win 为：如果走到该节点（即 A 出了 t[i] 后），接下来的玩家（B）能否必胜。
-        bool bWins = solve(b, a, t[i]);
-        node->win = bWins; 
-        
-        t[i]->back(a);
-        root->child.push_back(node);
-        
-        // 如果发现有一步能让 B 必败（即 node->win == false），则 A 必胜
-        if (node->win == false) { 
-            root->win = true;
-            // 找到必胜走法后，可以提前结束生成（如果只需要胜负结果）
-            // 但为了 UI 体验，我们可以选择生成所有走法，或者只生成这一步
-            // 这里保留 break 逻辑以加快响应，但注意这会导致 UI 只显示部分选项
-            // 如果想显示所有选项，应移除 break。
-            // 考虑到这是为了“展示最优解”，break 是合理的。
-            break;
+    emit(stateJson(tree, node, a, b, aTurn, true));
+
+    // 进度：分析期间每 PROGRESS_MS 毫秒由计时线程输出一行 progress 事件 (与 option 事件互斥输出)
+    int total = tree[node].childCount, proven = provenCount(tree, node);
+    std::mutex emitMu;
+    std::condition_variable finished;
+    bool done = false;
+    std::thread ticker;
+    if (control) {
+        ticker = std::thread([&] {
+            std::unique_lock<std::mutex> lock(emitMu);
+            while (!finished.wait_for(lock, std::chrono::milliseconds(PROGRESS_MS), [&] { return done; })) {
+                emit(progressJson(control, proven, total));
+            }
+        });
+    }
+    getTree(tree, node, hand, opp, control, [&](int i) {
+        std::lock_guard<std::mutex> lock(emitMu);
+        proven = provenCount(tree, node);
+        emit("{\"event\": \"option\", " + optionJson(tree, node, i).substr(1));
+    });
+    if (control) {
+        {
+            std::lock_guard<std::mutex> lock(emitMu);
+            done = true;
         }
+        finished.notify_one();
+        ticker.join();
+        emit(progressJson(control, proven, total));
     }
-}
\ No newline at end of file
+}
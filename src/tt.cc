@@ -0,0 +1,375 @@
+/**
+ * @file tt.cc
+ * @brief 固定大小置换表的实现
+ */
+
+#include "../include/tt.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const unsigned long long HAND_MASK = (1ULL << 45) - 1;
+static const int WIN_BIT = 51;
+static const int USED_BIT = 52;
+static const int GEN_SHIFT = 53;
+static const int WORK_SHIFT = 58;
+
+/**
+ * @brief 置换表文件头 (占据文件的前 4096 字节)
+ */
+struct TTFileHeader {
+    char magic[8];                 ///< "NEODOUTT"
+    unsigned int version;          ///< TT_FILE_VERSION
+    unsigned int entryBytes;       ///< 单个表项的字节数
+    unsigned long long buckets;    ///< 桶数 (2 的幂)
+};
+
+static const char TT_MAGIC[8] = {'N', 'E', 'O', 'D', 'O', 'U', 'T', 'T'};
+static const size_t TT_HEADER_BYTES = 4096;
+
+TransTable::TransTable()
+    : table(nullptr), raw(nullptr), bucketCount(0), generation(0), mapped(false), mapBytes(0)
+#ifdef _WIN32
+    , fileHandle(nullptr), mapHandle(nullptr)
+#endif
+{}
+
+TransTable::~TransTable() { release(); }
+
+void TransTable::release() {
+    if (mapped) {
+#ifdef _WIN32
+        FlushViewOfFile(raw, 0);
+        UnmapViewOfFile(raw);
+        CloseHandle((HANDLE)mapHandle);
+        CloseHandle((HANDLE)fileHandle);
+        mapHandle = fileHandle = nullptr;
+#else
+        msync(raw, mapBytes, MS_ASYNC);
+        munmap(raw, mapBytes);
+#endif
+        mapped = false;
+        mapBytes = 0;
+    } else {
+        free(raw);
+    }
+    raw = nullptr;
+    table = nullptr;
+    bucketCount = 0;
+}
+
+/**
+ * @brief 不超过内存预算的最大桶数 (2 的幂)
+ */
+static size_t bucketsFor(size_t mb, size_t bucketBytes) {
+    size_t budget = mb << 20;
+    size_t n = 1;
+    while (n * 2 * bucketBytes <= budget) n *= 2;
+    return n;
+}
+
+bool TransTable::resize(size_t mb) {
+    size_t n = bucketsFor(mb, sizeof(Bucket));
+    if (n == bucketCount && !mapped) {
+        clear();
+        return true;
+    }
+    release();
+    // 手动按 64 字节对齐，使每个桶恰好占一条缓存行。
+    // calloc 的清零页由操作系统按需提供，未触及的部分不占用物理内存。
+    raw = calloc(n * sizeof(Bucket) + 63, 1);
+    if (!raw) return false;
+    table = (Bucket *)(((size_t)raw + 63) & ~(size_t)63);
+    bucketCount = n;
+    generation = 0;
+    return true;
+}
+
+bool TransTable::mapFile(const char *path, size_t mb, std::string &err) {
+    release();
+    size_t n = bucketsFor(mb, sizeof(Bucket));
+    TTFileHeader want;
+    memset(&want, 0, sizeof(want));
+    memcpy(want.magic, TT_MAGIC, sizeof(TT_MAGIC));
+    want.version = TT_FILE_VERSION;
+    want.entryBytes = sizeof(Entry);
+    want.buckets = n;
+
+#ifdef _WIN32
+    HANDLE fh = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                            nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fh == INVALID_HANDLE_VALUE) {
+        err = string("cannot open ") + path;
+        return false;
+    }
+    // 初始化期间独占文件，避免两个进程同时创建
+    OVERLAPPED ov;
+    memset(&ov, 0, sizeof(ov));
+    LockFileEx(fh, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &ov);
+
+    TTFileHeader have;
+    memset(&have, 0, sizeof(have));
+    DWORD got = 0;
+    ReadFile(fh, &have, sizeof(have), &got, nullptr);
+    LARGE_INTEGER size;
+    GetFileSizeEx(fh, &size);
+    bool valid = got == sizeof(have) && memcmp(have.magic, TT_MAGIC, sizeof(TT_MAGIC)) == 0
+              && have.version == TT_FILE_VERSION && have.entryBytes == sizeof(Entry)
+              && have.buckets && (have.buckets & (have.buckets - 1)) == 0
+              && (unsigned long long)size.QuadPart == TT_HEADER_BYTES + have.buckets * sizeof(Bucket);
+    if (valid) n = have.buckets;
+
+    size_t total = TT_HEADER_BYTES + n * sizeof(Bucket);
+    if (!valid && size.QuadPart > 0) fprintf(stderr, "%s: incompatible hash file, reinitialized\n", path);
+    if (!valid) {
+        // 截断后重新扩展，新的区域由系统填零
+        LARGE_INTEGER zero, want_size;
+        zero.QuadPart = 0;
+        want_size.QuadPart = (LONGLONG)total;
+        SetFilePointerEx(fh, zero, nullptr, FILE_BEGIN);
+        SetEndOfFile(fh);
+        SetFilePointerEx(fh, want_size, nullptr, FILE_BEGIN);
+        SetEndOfFile(fh);
+    }
+    HANDLE mh = CreateFileMappingA(fh, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    void *p = mh ? MapViewOfFile(mh, FILE_MAP_ALL_ACCESS, 0, 0, total) : nullptr;
+    if (!p) {
+        if (mh) CloseHandle(mh);
+        UnlockFileEx(fh, 0, MAXDWORD, MAXDWORD, &ov);
+        CloseHandle(fh);
+        err = string("cannot map ") + path;
+        return false;
+    }
+    if (!valid) memcpy(p, &want, sizeof(want));
+    UnlockFileEx(fh, 0, MAXDWORD, MAXDWORD, &ov);
+    fileHandle = fh;
+    mapHandle = mh;
+#else
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        err = string("cannot open ") + path;
+        return false;
+    }
+    // 初始化期间独占文件，避免两个进程同时创建
+    flock(fd, LOCK_EX);
+
+    TTFileHeader have;
+    memset(&have, 0, sizeof(have));
+    struct stat st;
+    fstat(fd, &st);
+    bool valid = pread(fd, &have, sizeof(have), 0) == (ssize_t)sizeof(have)
+              && memcmp(have.magic, TT_MAGIC, sizeof(TT_MAGIC)) == 0
+              && have.version == TT_FILE_VERSION && have.entryBytes == sizeof(Entry)
+              && have.buckets && (have.buckets & (have.buckets - 1)) == 0
+              && (unsigned long long)st.st_size == TT_HEADER_BYTES + have.buckets * sizeof(Bucket);
+    if (valid) n = have.buckets;
+
+    size_t total = TT_HEADER_BYTES + n * sizeof(Bucket);
+    if (!valid && st.st_size > 0) fprintf(stderr, "%s: incompatible hash file, reinitialized\n", path);
+    if (!valid) {
+        // 截断后重新扩展，新的区域由系统填零
+        if (ftruncate(fd, 0) != 0 || ftruncate(fd, (off_t)total) != 0) {
+            flock(fd, LOCK_UN);
+            close(fd);
+            err = string("cannot resize ") + path;
+            return false;
+        }
+    }
+    void *p = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        flock(fd, LOCK_UN);
+        close(fd);
+        err = string("cannot map ") + path;
+        return false;
+    }
+    if (!valid) memcpy(p, &want, sizeof(want));
+    flock(fd, LOCK_UN);
+    // 映射建立后文件描述符不再需要
+    close(fd);
+#endif
+
+    raw = p;
+    mapped = true;
+    mapBytes = total;
+    table = (Bucket *)((char *)p + TT_HEADER_BYTES);
+    bucketCount = n;
+    generation = 0;
+    return true;
+}
+
+void TransTable::clear() {
+    if (table) memset((void *)table, 0, bucketCount * sizeof(Bucket));
+    generation = 0;
+}
+
+/**
+ * @brief 由局面构造表项的比较部分
+ */
+static inline void makeKey(Hand a, Hand b, unsigned int moveCode,
+                           unsigned long long &w0, unsigned long long &w1) {
+    w0 = (a.bits & HAND_MASK) | ((unsigned long long)(moveCode & 0x7FFFF) << 45);
+    w1 = (b.bits & HAND_MASK) | ((unsigned long long)(moveCode >> 19) << 45);
+}
+
+static const unsigned long long W1_KEY_MASK = (1ULL << WIN_BIT) - 1;
+
+bool TransTable::probe(const PositionKey &key, bool &win) const {
+    if (!table) return false;
+    unsigned long long w0, w1;
+    makeKey(key.a, key.b, key.code, w0, w1);
+    const Bucket &bk = table[key.hash & (bucketCount - 1)];
+    for (int i = 0; i < 4; i++) {
+        unsigned long long e1 = bk.e[i].w1.load(std::memory_order_relaxed);
+        unsigned long long e0 = bk.e[i].x0.load(std::memory_order_relaxed) ^ e1;
+        if (e0 == w0 && (e1 & W1_KEY_MASK) == w1 && ((e1 >> USED_BIT) & 1)) {
+            win = (e1 >> WIN_BIT) & 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TransTable::store(const PositionKey &key, bool win, unsigned long long nodes) {
+    if (!table) return;
+    unsigned long long w0, w1;
+    makeKey(key.a, key.b, key.code, w0, w1);
+
+    unsigned int work = 0;
+    while (nodes >>= 1) work++;
+    if (work > 63) work = 63;
+
+    Bucket &bk = table[key.hash & (bucketCount - 1)];
+    int victim = 0;
+    int victimScore = 1 << 30;
+    for (int i = 0; i < 4; i++) {
+        unsigned long long e1 = bk.e[i].w1.load(std::memory_order_relaxed);
+        unsigned long long e0 = bk.e[i].x0.load(std::memory_order_relaxed) ^ e1;
+        bool used = (e1 >> USED_BIT) & 1;
+        if (!used || (e0 == w0 && (e1 & W1_KEY_MASK) == w1)) {
+            victim = i;
+            break;
+        }
+        // 上一代的表项视为 work = -1，最先被淘汰
+        unsigned int gen = (e1 >> GEN_SHIFT) & 31;
+        int score = gen == generation ? (int)(e1 >> WORK_SHIFT) : -1;
+        if (score < victimScore) {
+            victimScore = score;
+            victim = i;
+        }
+    }
+
+    unsigned long long full = w1 | ((unsigned long long)win << WIN_BIT) | (1ULL << USED_BIT)
+                            | ((unsigned long long)generation << GEN_SHIFT)
+                            | ((unsigned long long)work << WORK_SHIFT);
+    Entry &e = bk.e[victim];
+    e.x0.store(w0 ^ full, std::memory_order_relaxed);
+    e.w1.store(full, std::memory_order_relaxed);
+}
+
+double TransTable::occupancy() const {
+    if (!table) return 0;
+    // 抽样前若干个桶估算占用率，避免扫描整张表
+    size_t n = bucketCount < 4096 ? bucketCount : 4096;
+    size_t used = 0;
+    for (size_t i = 0; i < n; i++) {
+        for (int j = 0; j < 4; j++) used += (table[i].e[j].w1.load(std::memory_order_relaxed) >> USED_BIT) & 1;
+    }
+    return (double)used / (n * 4);
+}
+
+// ==========================================
+// 分值置换表
+// ==========================================
+
+static const int BOUND_SHIFT = 16;
+static const int DEPTH_SHIFT = 18;
+static const int SCORE_GEN_SHIFT = 26;
+static const int SCORE_USED_BIT = 31;
+
+ScoreTable::ScoreTable() : table(nullptr), raw(nullptr), bucketCount(0), generation(0) {}
+
+ScoreTable::~ScoreTable() { free(raw); }
+
+bool ScoreTable::resize(size_t mb) {
+    size_t n = bucketsFor(mb, sizeof(Bucket));
+    if (n == bucketCount) {
+        clear();
+        return true;
+    }
+    free(raw);
+    table = nullptr;
+    bucketCount = 0;
+    raw = calloc(n * sizeof(Bucket) + 63, 1);
+    if (!raw) return false;
+    table = (Bucket *)(((size_t)raw + 63) & ~(size_t)63);
+    bucketCount = n;
+    generation = 0;
+    return true;
+}
+
+void ScoreTable::clear() {
+    if (table) memset((void *)table, 0, bucketCount * sizeof(Bucket));
+    generation = 0;
+}
+
+bool ScoreTable::probe(const PositionKey &key, int &value, Bound &bound) const {
+    if (!table) return false;
+    unsigned long long w0, w1;
+    makeKey(key.a, key.b, key.code, w0, w1);
+    const Bucket &bk = table[key.hash & (bucketCount - 1)];
+    for (int i = 0; i < 2; i++) {
+        unsigned long long d = bk.e[i].data.load(std::memory_order_relaxed);
+        if (!((d >> SCORE_USED_BIT) & 1)) continue;
+        if ((bk.e[i].x0.load(std::memory_order_relaxed) ^ d) != w0) continue;
+        if ((bk.e[i].x1.load(std::memory_order_relaxed) ^ d) != w1) continue;
+        value = (int)(d & 0xFFFF) - 32768;
+        bound = (Bound)((d >> BOUND_SHIFT) & 3);
+        return true;
+    }
+    return false;
+}
+
+void ScoreTable::store(const PositionKey &key, int value, Bound bound, int depth) {
+    if (!table) return;
+    unsigned long long w0, w1;
+    makeKey(key.a, key.b, key.code, w0, w1);
+
+    Bucket &bk = table[key.hash & (bucketCount - 1)];
+    int victim = 0;
+    int victimScore = 1 << 30;
+    for (int i = 0; i < 2; i++) {
+        unsigned long long d = bk.e[i].data.load(std::memory_order_relaxed);
+        bool used = (d >> SCORE_USED_BIT) & 1;
+        if (!used || ((bk.e[i].x0.load(std::memory_order_relaxed) ^ d) == w0
+                      && (bk.e[i].x1.load(std::memory_order_relaxed) ^ d) == w1)) {
+            victim = i;
+            break;
+        }
+        // 上一代的表项视为 depth = -1，最先被淘汰
+        unsigned int gen = (d >> SCORE_GEN_SHIFT) & 31;
+        int score = gen == generation ? (int)((d >> DEPTH_SHIFT) & 0xFF) : -1;
+        if (score < victimScore) {
+            victimScore = score;
+            victim = i;
+        }
+    }
+
+    unsigned long long d = (unsigned long long)((value + 32768) & 0xFFFF)
+                         | ((unsigned long long)bound << BOUND_SHIFT)
+                         | ((unsigned long long)(depth & 0xFF) << DEPTH_SHIFT)
+                         | ((unsigned long long)generation << SCORE_GEN_SHIFT)
+                         | (1ULL << SCORE_USED_BIT);
+    Entry &e = bk.e[victim];
+    e.x0.store(w0 ^ d, std::memory_order_relaxed);
+    e.x1.store(w1 ^ d, std::memory_order_relaxed);
+    e.data.store(d, std::memory_order_relaxed);
+}